@@ -110,7 +110,7 @@ bsp_t *const bsp = &brd_esp01_dimmer;
 
 esp_err_t board_early_init(void)
 {
-    esp_set_cpu_freq(ESP_CPU_FREQ_80M);
+    device_pm_configure(160, 80, false); // dimming runs at 80MHz, OTA holds max frequency
     settings_nvs_read(bsp->settings_pack);
     //settings_pack_print(bsp->settings_pack);
     return ESP_OK;
@@ -15,7 +15,19 @@
 #include <dht-sensor.h>
 #include <relay-channel.h>
 
-#ifdef CONFIG_BSP_ESP01_USB_DHT
+#if defined(CONFIG_BSP_ESP01_USB_DHT) || defined(CONFIG_BSP_ESP01_USB_DHT_BATTERY)
+
+#ifdef CONFIG_BSP_ESP01_USB_DHT_BATTERY
+#include <inttypes.h>
+#include <esp_timer.h>
+
+#define REPORT_CHECK_INTERVAL_MS 50
+#define REPORT_BACKOFF_MAX 3
+
+struct report_state {
+    uint32_t failures;
+};
+#endif
 
 static const char *TAG = "BSP";
 
@@ -37,14 +49,96 @@ static const settings_group_t board_settings[] = {
     {}
 };
 
+#ifdef CONFIG_BSP_ESP01_USB_DHT_BATTERY
+static bsp_t brd_esp01_usb = { .id = "ESP-01 USB DHT BAT",
+                               .ver = "1.0",
+                               .settings_pack = board_settings };
+#else
 static bsp_t brd_esp01_usb = { .id = "ESP-01 USB DHT",
                                .ver = "1.0",
                                .settings_pack = board_settings };
+#endif
 
 bsp_t *const bsp = &brd_esp01_usb;
 
 static supla_channel_t *dht_channel;
 
+#ifdef CONFIG_BSP_ESP01_USB_DHT_BATTERY
+static esp_timer_handle_t  report_timer;
+static int                 report_client = -1;
+static uint32_t            report_seq; // update sequence before sensor was read
+static int64_t             awake_time;
+static int64_t             sent_time;
+static struct report_state report_state;
+
+static void report_done(bool success)
+{
+    int64_t interval_us = CONFIG_BSP_DHT_REPORT_INTERVAL_S * 1000000LL;
+
+    if (success)
+        report_state.failures = 0;
+    else if (report_state.failures < REPORT_BACKOFF_MAX)
+        report_state.failures++;
+
+    // don't drain battery retrying when server or AP is unreachable
+    interval_us <<= report_state.failures;
+    device_sleep_rtc_store(&report_state, sizeof(report_state));
+
+    ESP_LOGI(TAG, "report %s, awake %" PRIu32 "ms", success ? "sent" : "failed",
+             (uint32_t)(esp_timer_get_time() / 1000));
+    esp_timer_stop(report_timer);
+    device_sleep_set_deadline(report_client, esp_timer_get_time() + interval_us);
+}
+
+/*
+ * Value is sent by supla loop once device is online. Sleep is entered after
+ * it leaves TCP buffers, report fails when it was not sent in awake time.
+ */
+static void report_check(void *arg)
+{
+    supla_dev_t      *dev = arg;
+    supla_dev_state_t state;
+    int64_t           now = esp_timer_get_time();
+
+    if (device_get_event_bits() & DEVICE_CONFIG_EVENT_BIT)
+        return;
+
+    if (!sent_time && device_update_seq() != report_seq && !device_update_pending() &&
+        supla_dev_get_state(dev, &state) == SUPLA_RESULT_TRUE && state == SUPLA_DEV_STATE_ONLINE)
+        sent_time = now;
+
+    if (sent_time && now - sent_time >= CONFIG_BSP_DHT_SEND_DELAY_MS * 1000LL)
+        report_done(true);
+    else if (!sent_time && now - awake_time >= CONFIG_BSP_DHT_AWAKE_TIMEOUT_MS * 1000LL)
+        report_done(false);
+}
+
+static esp_err_t report_init(supla_dev_t *dev)
+{
+    esp_timer_create_args_t timer_args = {
+        .name = "report",
+        .dispatch_method = ESP_TIMER_TASK,
+        .callback = report_check,
+        .arg = dev,
+    };
+    esp_err_t rc;
+
+    if (device_sleep_resumed())
+        device_sleep_rtc_restore(&report_state, sizeof(report_state));
+
+    rc = device_sleep_register("report", &report_client);
+    if (rc != ESP_OK)
+        return rc;
+
+    rc = esp_timer_create(&timer_args, &report_timer);
+    if (rc != ESP_OK)
+        return rc;
+
+    device_sleep_set_mode(DEVICE_SLEEP_MODE_DEEP);
+    return esp_timer_start_periodic(report_timer, REPORT_CHECK_INTERVAL_MS * 1000);
+}
+#endif
+
 static void button_cb(button_t *btn, button_state_t state)
 {
     EventBits_t bits = device_get_event_bits();
@@ -79,11 +173,20 @@ esp_err_t board_supla_init(supla_dev_t *dev)
     struct dht_channel_config dht_conf = {
         .sensor_type = dht_type_set ? dht_type_set->oneof.val : DHT_TYPE_AM2301,
         .gpio = GPIO_NUM_2,
+#ifdef CONFIG_BSP_ESP01_USB_DHT_BATTERY
+        .oneshot = true,
+#endif
     };
 
     button_init(&btn);
+#ifdef CONFIG_BSP_ESP01_USB_DHT_BATTERY
+    report_seq = device_update_seq(); // sensor is read once, on create
+#endif
     dht_channel = supla_channel_dht_create(&dht_conf);
     supla_dev_add_channel(dev, dht_channel);
+#ifdef CONFIG_BSP_ESP01_USB_DHT_BATTERY
+    ESP_ERROR_CHECK(report_init(dev));
+#endif
 
     ESP_LOGI(TAG, "board init completed with sensor: %s", dht_type_labels[dht_conf.sensor_type]);
     return ESP_OK;
@@ -91,11 +194,21 @@ esp_err_t board_supla_init(supla_dev_t *dev)
 
 esp_err_t board_on_config_mode_init(void)
 {
+#ifdef CONFIG_BSP_ESP01_USB_DHT_BATTERY
+    // stay awake while user configures the device
+    esp_timer_stop(report_timer);
+    device_sleep_set_busy(report_client);
+#endif
     return ESP_OK;
 }
 
 esp_err_t board_on_config_mode_exit(void)
 {
+#ifdef CONFIG_BSP_ESP01_USB_DHT_BATTERY
+    awake_time = esp_timer_get_time();
+    sent_time = 0;
+    esp_timer_start_periodic(report_timer, REPORT_CHECK_INTERVAL_MS * 1000);
+#endif
     return ESP_OK;
 }
 
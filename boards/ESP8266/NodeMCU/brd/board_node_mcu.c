@@ -20,6 +20,7 @@
 static const char *TAG = "BSP";
 
 #define COLOR_SETTINGS_GR "GR"
+#define MOTOR_SETTINGS_GR "MOTOR"
 
 static setting_t out_settings[] = {
     { .id = "COLOR",
@@ -29,8 +30,21 @@ static setting_t out_settings[] = {
     {} //last element
 };
 
+static setting_t motor_settings[] = {
+    { .id = "DELAY",
+      .label = "START DELAY [ms]",
+      .type = SETTING_TYPE_NUM,
+      .num = { 0, 0, { 0, 2000 } } },
+    { .id = "RUNON",
+      .label = "RUN-ON [ms]",
+      .type = SETTING_TYPE_NUM,
+      .num = { 0, 0, { 0, 2000 } } },
+    {} //last element
+};
+
 static const settings_group_t board_settings[] = {
     { .id = COLOR_SETTINGS_GR, .label = "GROUP", .settings = out_settings },
+    { .id = MOTOR_SETTINGS_GR, .label = "MOTOR", .settings = motor_settings },
     {}
 };
 
@@ -42,6 +56,19 @@ static supla_dev_t        *supla_dev;
 static supla_status_led_t *status_led;
 static supla_channel_t    *rs_channel;
 
+static int motor_setting(const char *id)
+{
+    setting_t *set = settings_pack_find(bsp->settings_pack, MOTOR_SETTINGS_GR, id);
+    return set ? set->num.val : 0;
+}
+
+static esp_err_t settings_handler(const settings_group_t *settings, void *arg)
+{
+    supla_channel_t *ch = arg;
+
+    return supla_rs_channel_set_motor_timing(ch, motor_setting("DELAY"), motor_setting("RUNON"));
+}
+
 static void button_cb(button_t *btn, button_state_t state)
 {
     EventBits_t bits = device_get_event_bits();
@@ -65,7 +92,7 @@ static button_t btn = { .gpio = GPIO_NUM_0, .callback = button_cb };
 
 esp_err_t board_early_init(void)
 {
-    esp_set_cpu_freq(ESP_CPU_FREQ_160M);
+    device_pm_configure(160, 160, false); // TLS to SUPLA server needs full speed
     settings_nvs_read(bsp->settings_pack);
     settings_pack_print(bsp->settings_pack);
     button_init(&btn);
@@ -83,7 +110,9 @@ esp_err_t board_supla_init(supla_dev_t *dev)
         .gpio_open = GPIO_NUM_4,
         .gpio_close = GPIO_NUM_5,
         .default_function = SUPLA_CHANNELFNC_CONTROLLINGTHEROLLERSHUTTER,
-        .supported_functions = RS_CH_SUPPORTED_FUNC_BITS //
+        .supported_functions = RS_CH_SUPPORTED_FUNC_BITS,
+        .start_delay_ms = motor_setting("DELAY"),
+        .run_on_ms = motor_setting("RUNON") //
     };
 
     status_led = supla_status_led_init(dev, &led_conf);
@@ -92,6 +121,7 @@ esp_err_t board_supla_init(supla_dev_t *dev)
 
     supla_dev_add_channel(dev, rs_channel);
     //supla_dev_enable_notifications(dev, 0x00);
+    settings_handler_register(settings_handler, rs_channel);
 
     supla_dev = dev; //store pointer
     ESP_LOGI(TAG, "board init completed OK");
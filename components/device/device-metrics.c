@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2025 <qb4.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "device-priv.h"
+#include <string.h>
+#include <esp_timer.h>
+#include <freertos/semphr.h>
+
+static SemaphoreHandle_t metrics_lock;
+static device_metrics_t  metrics;
+
+// channels are created before any command arrives, lock is created by first of them
+static bool metrics_take(void)
+{
+    if (!metrics_lock)
+        metrics_lock = xSemaphoreCreateMutex();
+    return metrics_lock && xSemaphoreTake(metrics_lock, portMAX_DELAY) == pdTRUE;
+}
+
+static device_channel_metrics_t *channel_metrics_get(void *channel)
+{
+    device_channel_metrics_t *ch;
+
+    for (int i = 0; i < metrics.channels_num; i++) {
+        if (metrics.channels[i].channel == channel)
+            return &metrics.channels[i];
+    }
+    if (metrics.channels_num >= DEVICE_METRICS_CHANNELS_MAX)
+        return NULL;
+
+    ch = &metrics.channels[metrics.channels_num++];
+    ch->channel = channel;
+    return ch;
+}
+
+void device_metrics_set_value(void *channel, int64_t start_us)
+{
+    uint32_t                  latency_us = esp_timer_get_time() - start_us;
+    device_channel_metrics_t *ch;
+
+    if (!metrics_take())
+        return;
+
+    ch = channel_metrics_get(channel);
+    if (ch) {
+        ch->set_value_count++;
+        ch->latency_sum_us += latency_us;
+        if (latency_us > ch->latency_max_us)
+            ch->latency_max_us = latency_us;
+    }
+    xSemaphoreGive(metrics_lock);
+}
+
+void device_metrics_nvs_write(void)
+{
+    if (!metrics_take())
+        return;
+
+    metrics.nvs_writes++;
+    xSemaphoreGive(metrics_lock);
+}
+
+void device_metrics_journal_write(void)
+{
+    if (!metrics_take())
+        return;
+
+    metrics.journal_writes++;
+    xSemaphoreGive(metrics_lock);
+}
+
+void device_metrics_journal_erase(void)
+{
+    if (!metrics_take())
+        return;
+
+    metrics.journal_erases++;
+    xSemaphoreGive(metrics_lock);
+}
+
+esp_err_t device_metrics_get(device_metrics_t *m)
+{
+    if (!m)
+        return ESP_ERR_INVALID_ARG;
+    if (!metrics_take())
+        return ESP_ERR_NO_MEM;
+
+    memcpy(m, &metrics, sizeof(metrics));
+    xSemaphoreGive(metrics_lock);
+    return ESP_OK;
+}
@@ -0,0 +1,235 @@
+/*
+ * Copyright (c) 2025 <qb4.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "device-priv.h"
+#include <stdlib.h>
+#include <string.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+#include <freertos/semphr.h>
+
+#ifndef CONFIG_IDF_TARGET_ESP8266
+#include <esp_idf_version.h>
+#endif
+#ifdef CONFIG_PM_ENABLE
+#include <esp_pm.h>
+#endif
+
+struct device_pm_lock {
+    device_pm_lock_type_t type;
+    const char           *name;
+    uint32_t              count;
+#ifdef CONFIG_PM_ENABLE
+    esp_pm_lock_handle_t pm_lock;
+#endif
+};
+
+static const char *TAG = "PM";
+
+static SemaphoreHandle_t pm_mutex;
+static bool              pm_configured;
+static int               pm_max_freq_mhz;
+static int               pm_min_freq_mhz;
+static uint32_t          pm_holders[DEVICE_PM_LOCK_TYPE_MAX];
+static int64_t           pm_hold_start[DEVICE_PM_LOCK_TYPE_MAX];
+static int64_t           pm_hold_time[DEVICE_PM_LOCK_TYPE_MAX];
+
+static esp_err_t pm_init_once(void)
+{
+    if (!pm_mutex)
+        pm_mutex = xSemaphoreCreateMutex();
+    return pm_mutex ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+#ifdef CONFIG_IDF_TARGET_ESP8266
+// no esp_pm on ESP8266, switch CPU clock directly; APB clock is fixed there
+static void pm_update_cpu_freq(void)
+{
+    int freq_mhz = pm_holders[DEVICE_PM_CPU_FREQ_MAX] ? pm_max_freq_mhz : pm_min_freq_mhz;
+
+    if (pm_configured)
+        esp_set_cpu_freq(freq_mhz == 160 ? ESP_CPU_FREQ_160M : ESP_CPU_FREQ_80M);
+}
+#endif
+
+esp_err_t device_pm_configure(int max_freq_mhz, int min_freq_mhz, bool light_sleep)
+{
+    esp_err_t rc = pm_init_once();
+
+    if (rc != ESP_OK)
+        return rc;
+    if (min_freq_mhz > max_freq_mhz)
+        return ESP_ERR_INVALID_ARG;
+
+    xSemaphoreTake(pm_mutex, portMAX_DELAY);
+    pm_max_freq_mhz = max_freq_mhz;
+    pm_min_freq_mhz = min_freq_mhz;
+#ifdef CONFIG_IDF_TARGET_ESP8266
+    pm_configured = true;
+    pm_update_cpu_freq();
+#elif defined(CONFIG_PM_ENABLE) && ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+    esp_pm_config_t pm_config = {
+        .max_freq_mhz = max_freq_mhz,
+        .min_freq_mhz = min_freq_mhz,
+        .light_sleep_enable = light_sleep,
+    };
+    rc = esp_pm_configure(&pm_config);
+    pm_configured = rc == ESP_OK;
+#else
+    rc = ESP_ERR_NOT_SUPPORTED; // locks are still accounted
+#endif
+    xSemaphoreGive(pm_mutex);
+
+    ESP_LOGI(TAG, "cpu %d-%dMHz light sleep %s: %s", min_freq_mhz, max_freq_mhz,
+             light_sleep ? "on" : "off", esp_err_to_name(rc));
+    return rc;
+}
+
+esp_err_t device_pm_init(void)
+{
+    esp_err_t rc = pm_init_once();
+
+    if (rc != ESP_OK || pm_configured)
+        return rc;
+
+    // CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ is there since IDF 5.0, like generic esp_pm_config_t
+#if defined(CONFIG_PM_ENABLE) && defined(CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ)
+#ifdef CONFIG_FREERTOS_USE_TICKLESS_IDLE
+    device_pm_configure(CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ, CONFIG_XTAL_FREQ, true);
+#else
+    device_pm_configure(CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ, CONFIG_XTAL_FREQ, false);
+#endif
+#endif
+    return ESP_OK;
+}
+
+esp_err_t device_pm_lock_create(device_pm_lock_type_t type, const char *name,
+                                device_pm_lock_handle_t *handle)
+{
+    struct device_pm_lock *lock;
+    esp_err_t              rc;
+
+    if (type >= DEVICE_PM_LOCK_TYPE_MAX || !handle)
+        return ESP_ERR_INVALID_ARG;
+
+    rc = pm_init_once();
+    if (rc != ESP_OK)
+        return rc;
+
+    lock = calloc(1, sizeof(struct device_pm_lock));
+    if (!lock)
+        return ESP_ERR_NO_MEM;
+
+    lock->type = type;
+    lock->name = name;
+#ifdef CONFIG_PM_ENABLE
+    static const esp_pm_lock_type_t pm_lock_types[DEVICE_PM_LOCK_TYPE_MAX] = {
+        [DEVICE_PM_CPU_FREQ_MAX] = ESP_PM_CPU_FREQ_MAX,
+        [DEVICE_PM_APB_FREQ_MAX] = ESP_PM_APB_FREQ_MAX,
+        [DEVICE_PM_NO_LIGHT_SLEEP] = ESP_PM_NO_LIGHT_SLEEP,
+    };
+
+    rc = esp_pm_lock_create(pm_lock_types[type], 0, name, &lock->pm_lock);
+    if (rc != ESP_OK) {
+        free(lock);
+        return rc;
+    }
+#endif
+    *handle = lock;
+    return ESP_OK;
+}
+
+esp_err_t device_pm_lock_delete(device_pm_lock_handle_t lock)
+{
+    if (!lock)
+        return ESP_ERR_INVALID_ARG;
+    if (lock->count)
+        return ESP_ERR_INVALID_STATE;
+
+#ifdef CONFIG_PM_ENABLE
+    esp_pm_lock_delete(lock->pm_lock);
+#endif
+    free(lock);
+    return ESP_OK;
+}
+
+esp_err_t device_pm_lock_acquire(device_pm_lock_handle_t lock)
+{
+    if (!lock)
+        return ESP_ERR_INVALID_ARG;
+
+    xSemaphoreTake(pm_mutex, portMAX_DELAY);
+    lock->count++;
+    if (pm_holders[lock->type]++ == 0) {
+        pm_hold_start[lock->type] = esp_timer_get_time();
+#ifdef CONFIG_IDF_TARGET_ESP8266
+        pm_update_cpu_freq();
+#endif
+    }
+#ifdef CONFIG_PM_ENABLE
+    esp_pm_lock_acquire(lock->pm_lock);
+#endif
+    xSemaphoreGive(pm_mutex);
+    return ESP_OK;
+}
+
+esp_err_t device_pm_lock_release(device_pm_lock_handle_t lock)
+{
+    if (!lock)
+        return ESP_ERR_INVALID_ARG;
+
+    xSemaphoreTake(pm_mutex, portMAX_DELAY);
+    if (!lock->count) {
+        xSemaphoreGive(pm_mutex);
+        ESP_LOGW(TAG, "lock %s not acquired", lock->name);
+        return ESP_ERR_INVALID_STATE;
+    }
+    lock->count--;
+    if (--pm_holders[lock->type] == 0) {
+        pm_hold_time[lock->type] += esp_timer_get_time() - pm_hold_start[lock->type];
+#ifdef CONFIG_IDF_TARGET_ESP8266
+        pm_update_cpu_freq();
+#endif
+    }
+#ifdef CONFIG_PM_ENABLE
+    esp_pm_lock_release(lock->pm_lock);
+#endif
+    xSemaphoreGive(pm_mutex);
+    return ESP_OK;
+}
+
+esp_err_t device_pm_get_report(device_pm_report_t *report)
+{
+    int64_t now = esp_timer_get_time();
+    int64_t cpu_max_time, cpu_min_time;
+
+    if (!report || !pm_mutex)
+        return ESP_ERR_INVALID_ARG;
+
+    xSemaphoreTake(pm_mutex, portMAX_DELAY);
+    for (int i = 0; i < DEVICE_PM_LOCK_TYPE_MAX; i++) {
+        int64_t held = pm_hold_time[i];
+
+        if (pm_holders[i])
+            held += now - pm_hold_start[i];
+        report->lock_time_ms[i] = held / 1000;
+    }
+    report->max_freq_mhz = pm_max_freq_mhz;
+    report->min_freq_mhz = pm_min_freq_mhz;
+    xSemaphoreGive(pm_mutex);
+
+    // CPU runs at max frequency at least while locked, average is a lower bound
+    cpu_max_time = report->lock_time_ms[DEVICE_PM_CPU_FREQ_MAX];
+    report->uptime_ms = now / 1000;
+    cpu_min_time = report->uptime_ms - cpu_max_time;
+    report->avg_freq_mhz = 0;
+    if (report->uptime_ms && pm_configured) {
+        report->avg_freq_mhz = (cpu_max_time * report->max_freq_mhz +
+                                cpu_min_time * report->min_freq_mhz) /
+                               report->uptime_ms;
+    }
+    return ESP_OK;
+}
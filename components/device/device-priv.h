@@ -0,0 +1,15 @@
+/*
+ * Copyright (c) 2025 <qb4.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#ifndef DEVICE_PRIV_H_
+#define DEVICE_PRIV_H_
+
+#include "include/device.h"
+
+esp_err_t device_sleep_init(void);
+esp_err_t device_pm_init(void);
+
+#endif /* DEVICE_PRIV_H_ */
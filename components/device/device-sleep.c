@@ -0,0 +1,297 @@
+/*
+ * Copyright (c) 2025 <qb4.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "device-priv.h"
+#include <string.h>
+#include <inttypes.h>
+#include <esp_attr.h>
+#include <esp_sleep.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+#include <freertos/semphr.h>
+
+#define SLEEP_CLIENTS_MAX 8
+#define SLEEP_RTC_MAGIC 0x534c5045
+
+struct sleep_client {
+    const char *name;
+    int64_t     wake_at_us;
+    bool        busy;
+};
+
+struct sleep_rtc_state {
+    uint32_t magic;
+    uint32_t deep_sleep_cycles;
+    int64_t  time_us[DEVICE_SLEEP_MODE_MAX];
+    uint32_t data_len;
+    uint8_t  data[CONFIG_DEVICE_SLEEP_RTC_DATA_SIZE];
+};
+
+static const char *TAG = "SLEEP";
+
+static const uint32_t sleep_current_ua[DEVICE_SLEEP_MODE_MAX] = {
+    [DEVICE_SLEEP_MODE_NONE] = CONFIG_DEVICE_SLEEP_CURRENT_ACTIVE_UA,
+    [DEVICE_SLEEP_MODE_MODEM] = CONFIG_DEVICE_SLEEP_CURRENT_MODEM_UA,
+    [DEVICE_SLEEP_MODE_LIGHT] = CONFIG_DEVICE_SLEEP_CURRENT_LIGHT_UA,
+    [DEVICE_SLEEP_MODE_DEEP] = CONFIG_DEVICE_SLEEP_CURRENT_DEEP_UA
+};
+
+RTC_DATA_ATTR static struct sleep_rtc_state rtc_state;
+
+static struct sleep_client     clients[SLEEP_CLIENTS_MAX];
+static int                     clients_num;
+static SemaphoreHandle_t       sleep_lock;
+static device_sleep_mode_t     max_sleep_mode = DEVICE_SLEEP_MODE_NONE;
+static device_sleep_mode_t     sleep_mode = DEVICE_SLEEP_MODE_NONE;
+static int64_t                 sleep_mode_time;
+static bool                    sleep_pending;
+static bool                    sleep_resumed;
+
+// must be called with sleep_lock taken
+static void sleep_mode_switch(device_sleep_mode_t mode)
+{
+    int64_t now = esp_timer_get_time();
+
+    rtc_state.time_us[sleep_mode] += now - sleep_mode_time;
+    sleep_mode = mode;
+    sleep_mode_time = now;
+}
+
+// must be called with sleep_lock taken
+static int64_t sleep_idle_time(void)
+{
+    int64_t now = esp_timer_get_time();
+    int64_t wake_at = 0;
+
+    for (int i = 0; i < clients_num; i++) {
+        if (clients[i].busy)
+            return 0;
+        if (clients[i].wake_at_us && (!wake_at || clients[i].wake_at_us < wake_at))
+            wake_at = clients[i].wake_at_us;
+    }
+    if (!wake_at)
+        return INT64_MAX; // all idle with no deadline
+    return wake_at > now ? wake_at - now : 0;
+}
+
+static device_sleep_mode_t sleep_mode_select(int64_t idle_us)
+{
+    // deep sleep needs a wake up deadline, device would never wake up otherwise
+    if (max_sleep_mode >= DEVICE_SLEEP_MODE_DEEP && idle_us != INT64_MAX &&
+        idle_us >= CONFIG_DEVICE_SLEEP_MIN_DEEP_MS * 1000LL)
+        return DEVICE_SLEEP_MODE_DEEP;
+    if (max_sleep_mode >= DEVICE_SLEEP_MODE_LIGHT && idle_us != INT64_MAX &&
+        idle_us >= CONFIG_DEVICE_SLEEP_MIN_LIGHT_MS * 1000LL)
+        return DEVICE_SLEEP_MODE_LIGHT;
+    if (max_sleep_mode >= DEVICE_SLEEP_MODE_MODEM && idle_us > 0)
+        return DEVICE_SLEEP_MODE_MODEM;
+    return DEVICE_SLEEP_MODE_NONE;
+}
+
+static void sleep_resume(void)
+{
+    sleep_pending = false;
+    device_event_post(DEVICE_EVENT_SLEEP_RESUME, NULL, 0);
+    device_notify_update(); // push values measured while sleeping
+}
+
+static void sleep_event_handler(void *arg, esp_event_base_t base, int32_t id, void *data)
+{
+    device_sleep_event_t *ev = data;
+    device_sleep_mode_t   mode;
+    int64_t               idle_us;
+
+    // application handlers run first, deadlines might have changed meanwhile
+    xSemaphoreTake(sleep_lock, portMAX_DELAY);
+    idle_us = sleep_idle_time();
+    mode = sleep_mode_select(idle_us);
+    if (mode != ev->mode) {
+        xSemaphoreGive(sleep_lock);
+        ESP_LOGD(TAG, "sleep aborted");
+        sleep_resume();
+        return;
+    }
+    sleep_mode_switch(mode);
+
+    switch (mode) {
+    case DEVICE_SLEEP_MODE_MODEM:
+        // radio power save is set by application, stay here until client gets busy
+        sleep_pending = false;
+        xSemaphoreGive(sleep_lock);
+        break;
+    case DEVICE_SLEEP_MODE_LIGHT:
+        xSemaphoreGive(sleep_lock);
+        esp_sleep_enable_timer_wakeup(idle_us);
+        esp_light_sleep_start();
+
+        xSemaphoreTake(sleep_lock, portMAX_DELAY);
+        sleep_mode_switch(DEVICE_SLEEP_MODE_NONE);
+        xSemaphoreGive(sleep_lock);
+        sleep_resume();
+        break;
+    case DEVICE_SLEEP_MODE_DEEP:
+        // esp_timer restarts after reset, so account planned sleep time upfront
+        rtc_state.time_us[DEVICE_SLEEP_MODE_DEEP] += idle_us;
+        rtc_state.deep_sleep_cycles++;
+        xSemaphoreGive(sleep_lock);
+        ESP_LOGI(TAG, "deep sleep for %" PRIu32 "ms", (uint32_t)(idle_us / 1000));
+        esp_deep_sleep(idle_us);
+        break;
+    default:
+        xSemaphoreGive(sleep_lock);
+        break;
+    }
+}
+
+esp_err_t device_sleep_init(void)
+{
+    sleep_lock = xSemaphoreCreateMutex();
+    if (!sleep_lock)
+        return ESP_ERR_NO_MEM;
+
+    sleep_resumed =
+        esp_reset_reason() == ESP_RST_DEEPSLEEP && rtc_state.magic == SLEEP_RTC_MAGIC;
+    if (!sleep_resumed) {
+        memset(&rtc_state, 0, sizeof(rtc_state));
+        rtc_state.magic = SLEEP_RTC_MAGIC;
+    }
+
+    /* registered after application handler, so sleep starts when application is ready */
+    return device_event_register(DEVICE_EVENT_SLEEP_INIT, sleep_event_handler, NULL);
+}
+
+esp_err_t device_sleep_register(const char *name, int *client)
+{
+    esp_err_t rc = ESP_OK;
+
+    if (!sleep_lock || !client)
+        return ESP_ERR_INVALID_STATE;
+
+    xSemaphoreTake(sleep_lock, portMAX_DELAY);
+    if (clients_num < SLEEP_CLIENTS_MAX) {
+        clients[clients_num].name = name;
+        clients[clients_num].wake_at_us = 0;
+        clients[clients_num].busy = true;
+        *client = clients_num++;
+    } else {
+        ESP_LOGE(TAG, "too many sleep clients");
+        rc = ESP_ERR_NO_MEM;
+    }
+    xSemaphoreGive(sleep_lock);
+    return rc;
+}
+
+esp_err_t device_sleep_set_deadline(int client, int64_t wake_at_us)
+{
+    if (client < 0 || client >= clients_num)
+        return ESP_ERR_INVALID_ARG;
+
+    xSemaphoreTake(sleep_lock, portMAX_DELAY);
+    clients[client].wake_at_us = wake_at_us;
+    clients[client].busy = false;
+    xSemaphoreGive(sleep_lock);
+    return ESP_OK;
+}
+
+esp_err_t device_sleep_set_busy(int client)
+{
+    bool resume = false;
+
+    if (client < 0 || client >= clients_num)
+        return ESP_ERR_INVALID_ARG;
+
+    xSemaphoreTake(sleep_lock, portMAX_DELAY);
+    clients[client].busy = true;
+    if (sleep_mode == DEVICE_SLEEP_MODE_MODEM) {
+        sleep_mode_switch(DEVICE_SLEEP_MODE_NONE);
+        resume = true;
+    }
+    xSemaphoreGive(sleep_lock);
+
+    if (resume)
+        sleep_resume();
+    return ESP_OK;
+}
+
+esp_err_t device_sleep_set_mode(device_sleep_mode_t max_mode)
+{
+    if (max_mode >= DEVICE_SLEEP_MODE_MAX)
+        return ESP_ERR_INVALID_ARG;
+
+    max_sleep_mode = max_mode;
+    return ESP_OK;
+}
+
+esp_err_t device_sleep_enter(void)
+{
+    device_sleep_event_t ev = {};
+
+    if (!sleep_lock || max_sleep_mode == DEVICE_SLEEP_MODE_NONE)
+        return ESP_ERR_NOT_SUPPORTED;
+
+    xSemaphoreTake(sleep_lock, portMAX_DELAY);
+    ev.duration_us = sleep_idle_time();
+    ev.mode = sleep_mode_select(ev.duration_us);
+    // from modem sleep device can go deeper only
+    if (sleep_pending || ev.mode <= sleep_mode) {
+        xSemaphoreGive(sleep_lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (ev.duration_us == INT64_MAX)
+        ev.duration_us = 0;
+    sleep_pending = true;
+    xSemaphoreGive(sleep_lock);
+
+    if (device_event_post(DEVICE_EVENT_SLEEP_INIT, &ev, sizeof(ev)) != ESP_OK) {
+        sleep_pending = false;
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+bool device_sleep_resumed(void)
+{
+    return sleep_resumed;
+}
+
+esp_err_t device_sleep_rtc_store(const void *data, size_t len)
+{
+    if (len > sizeof(rtc_state.data))
+        return ESP_ERR_INVALID_SIZE;
+
+    memcpy(rtc_state.data, data, len);
+    rtc_state.data_len = len;
+    return ESP_OK;
+}
+
+esp_err_t device_sleep_rtc_restore(void *data, size_t len)
+{
+    if (!sleep_resumed || rtc_state.data_len != len)
+        return ESP_ERR_NOT_FOUND;
+
+    memcpy(data, rtc_state.data, len);
+    return ESP_OK;
+}
+
+esp_err_t device_sleep_get_report(device_sleep_report_t *report)
+{
+    int64_t time_us[DEVICE_SLEEP_MODE_MAX];
+
+    if (!report || !sleep_lock)
+        return ESP_ERR_INVALID_ARG;
+
+    xSemaphoreTake(sleep_lock, portMAX_DELAY);
+    memcpy(time_us, rtc_state.time_us, sizeof(time_us));
+    time_us[sleep_mode] += esp_timer_get_time() - sleep_mode_time;
+    report->deep_sleep_cycles = rtc_state.deep_sleep_cycles;
+    xSemaphoreGive(sleep_lock);
+
+    for (int i = 0; i < DEVICE_SLEEP_MODE_MAX; i++) {
+        report->time_ms[i] = time_us[i] / 1000;
+        report->charge_mah[i] = (float)time_us[i] * sleep_current_ua[i] / 3.6e12f;
+    }
+    return ESP_OK;
+}
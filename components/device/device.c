@@ -4,7 +4,14 @@
  * SPDX-License-Identifier: LGPL-2.1-or-later
  */
 
-#include "device.h"
+#include "device-priv.h"
+#include <esp_timer.h>
+
+#include <string.h>
+#include <freertos/queue.h>
+
+#define DEVICE_UPDATE_EVENT_BIT BIT1
+#define DEVICE_EVENT_HANDLERS_MAX 8
 
 /**
  * @brief Define device event base
@@ -12,59 +19,197 @@
  */
 ESP_EVENT_DEFINE_BASE(DEV_EVENT);
 
+struct device_event {
+    int32_t id;
+    int64_t post_time;
+    size_t  size;
+    uint8_t data[DEVICE_EVENT_DATA_MAX];
+};
+
+struct device_event_handler {
+    int32_t             id;
+    esp_event_handler_t handler;
+    void               *arg;
+};
+
 static const char *TAG = "DEV";
 
-static EventGroupHandle_t      dev_event_group;
-static esp_event_loop_handle_t event_loop_hdl;
-static TaskHandle_t            tsk_hdl;
+static const uint32_t latency_bucket_limits_us[DEVICE_EVENT_LATENCY_BUCKETS - 1] = {
+    1000, 10000, 100000, 1000000
+};
+
+static EventGroupHandle_t          dev_event_group;
+static QueueHandle_t               event_queues[DEVICE_EVENT_PRIO_MAX];
+static struct device_event_handler event_handlers[DEVICE_EVENT_HANDLERS_MAX];
+static int                         event_handlers_num;
+static device_event_stats_t        event_stats;
+static TaskHandle_t                tsk_hdl;
+static volatile int64_t            update_notify_time;
+static volatile uint32_t           update_seq; // device_notify_update() calls
+static volatile uint32_t           update_sent_seq;
+
+static device_event_prio_t device_event_prio(int32_t event_id)
+{
+    switch (event_id) {
+    case DEVICE_EVENT_VALUE_CHANGED:
+    case DEVICE_EVENT_INPUT:
+        return DEVICE_EVENT_PRIO_NORMAL;
+    default:
+        return DEVICE_EVENT_PRIO_HIGH;
+    }
+}
+
+static void device_event_dispatch(device_event_prio_t prio, struct device_event *ev)
+{
+    uint32_t latency_us = esp_timer_get_time() - ev->post_time;
+    int      bucket = 0;
+
+    while (bucket < DEVICE_EVENT_LATENCY_BUCKETS - 1 &&
+           latency_us >= latency_bucket_limits_us[bucket])
+        bucket++;
+    event_stats.latency_hist[prio][bucket]++;
+    if (latency_us > event_stats.latency_max_us[prio])
+        event_stats.latency_max_us[prio] = latency_us;
+
+    for (int i = 0; i < event_handlers_num; i++) {
+        struct device_event_handler *eh = &event_handlers[i];
+
+        if (eh->id == ESP_EVENT_ANY_ID || eh->id == ev->id)
+            eh->handler(eh->arg, DEV_EVENT, ev->id, ev->size ? ev->data : NULL);
+    }
+}
 
 static void device_task_entry(void *arg)
 {
+    struct device_event ev;
+
     while (1) {
-        esp_event_loop_run(event_loop_hdl, pdMS_TO_TICKS(1000));
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        // high priority queue is checked again before each normal event
+        while (1) {
+            if (xQueueReceive(event_queues[DEVICE_EVENT_PRIO_HIGH], &ev, 0) == pdTRUE)
+                device_event_dispatch(DEVICE_EVENT_PRIO_HIGH, &ev);
+            else if (xQueueReceive(event_queues[DEVICE_EVENT_PRIO_NORMAL], &ev, 0) == pdTRUE)
+                device_event_dispatch(DEVICE_EVENT_PRIO_NORMAL, &ev);
+            else
+                break;
+        }
     }
     vTaskDelete(NULL);
 }
 
 esp_err_t device_init(esp_event_handler_t ev_hdl, void *args)
 {
-    esp_event_loop_args_t loop_args = { .queue_size = 4, .task_name = NULL };
-    esp_err_t             esp_err;
+    esp_err_t esp_err;
 
     dev_event_group = xEventGroupCreate();
     if (!dev_event_group)
         return ESP_ERR_NO_MEM;
 
-    esp_err = esp_event_loop_create(&loop_args, &event_loop_hdl);
-    if (esp_err != ESP_OK) {
-        ESP_LOGE(TAG, "event loop create error");
-        goto loop_failed;
+    for (int i = 0; i < DEVICE_EVENT_PRIO_MAX; i++) {
+        event_queues[i] =
+            xQueueCreate(CONFIG_DEVICE_EVENT_QUEUE_DEPTH, sizeof(struct device_event));
+        if (!event_queues[i]) {
+            ESP_LOGE(TAG, "event queue create error");
+            goto queue_failed;
+        }
     }
 
-    esp_err =
-        esp_event_handler_register_with(event_loop_hdl, DEV_EVENT, ESP_EVENT_ANY_ID, ev_hdl, args);
+    esp_err = device_event_register(ESP_EVENT_ANY_ID, ev_hdl, args);
     if (esp_err != ESP_OK) {
         ESP_LOGE(TAG, "event handler register failed");
-        goto eh_failed;
+        goto queue_failed;
     }
 
-    BaseType_t err = xTaskCreate(device_task_entry, "dev", 4096, NULL, tskIDLE_PRIORITY, &tsk_hdl);
+    esp_err = device_pm_init();
+    if (esp_err != ESP_OK) {
+        ESP_LOGE(TAG, "pm init failed");
+        goto queue_failed;
+    }
+
+    esp_err = device_sleep_init();
+    if (esp_err != ESP_OK) {
+        ESP_LOGE(TAG, "sleep init failed");
+        goto queue_failed;
+    }
+
+    BaseType_t err = xTaskCreate(device_task_entry, "dev", 4096, NULL,
+                                 CONFIG_DEVICE_EVENT_TASK_PRIORITY, &tsk_hdl);
     if (err != pdTRUE) {
         ESP_LOGE(TAG, "task create failed");
-        goto task_failed;
+        goto queue_failed;
     }
 
     ESP_LOGI(TAG, "init OK");
     return ESP_OK;
 
-task_failed:
-eh_failed:
-    esp_event_loop_delete(event_loop_hdl);
-loop_failed:
+queue_failed:
+    for (int i = 0; i < DEVICE_EVENT_PRIO_MAX; i++) {
+        if (event_queues[i])
+            vQueueDelete(event_queues[i]);
+        event_queues[i] = NULL;
+    }
+    event_handlers_num = 0;
     vEventGroupDelete(dev_event_group);
     return ESP_FAIL;
 }
 
+esp_err_t device_event_register(int32_t event_id, esp_event_handler_t handler, void *arg)
+{
+    if (!handler)
+        return ESP_ERR_INVALID_ARG;
+    if (event_handlers_num >= DEVICE_EVENT_HANDLERS_MAX)
+        return ESP_ERR_NO_MEM;
+
+    event_handlers[event_handlers_num].id = event_id;
+    event_handlers[event_handlers_num].handler = handler;
+    event_handlers[event_handlers_num].arg = arg;
+    event_handlers_num++;
+    return ESP_OK;
+}
+
+esp_err_t device_event_post(int32_t event_id, const void *data, size_t size)
+{
+    device_event_prio_t prio = device_event_prio(event_id);
+    struct device_event ev = { .id = event_id, .size = size };
+
+    if (size > DEVICE_EVENT_DATA_MAX || (size && !data))
+        return ESP_ERR_INVALID_ARG;
+    if (!tsk_hdl)
+        return ESP_ERR_INVALID_STATE;
+
+    if (size)
+        memcpy(ev.data, data, size);
+    ev.post_time = esp_timer_get_time();
+
+    // never block, producers are often timer callbacks
+    if (xQueueSend(event_queues[prio], &ev, 0) != pdTRUE) {
+        event_stats.dropped[prio]++;
+        return ESP_ERR_TIMEOUT;
+    }
+    event_stats.posted[prio]++;
+    xTaskNotifyGive(tsk_hdl);
+    return ESP_OK;
+}
+
+esp_err_t device_publish(device_event_id_t event_id, void *channel, int32_t code)
+{
+    device_channel_event_t ev = { .channel = channel, .code = code };
+
+    return device_event_post(event_id, &ev, sizeof(ev));
+}
+
+esp_err_t device_event_get_stats(device_event_stats_t *stats)
+{
+    if (!stats)
+        return ESP_ERR_INVALID_ARG;
+
+    memcpy(stats, &event_stats, sizeof(event_stats));
+    for (int i = 0; i < DEVICE_EVENT_PRIO_MAX; i++)
+        stats->pending[i] = event_queues[i] ? uxQueueMessagesWaiting(event_queues[i]) : 0;
+    return ESP_OK;
+}
+
 EventBits_t device_get_event_bits(void)
 {
     return xEventGroupGetBits(dev_event_group);
@@ -79,7 +224,11 @@ esp_err_t device_init_config(void)
 
     ESP_LOGW(TAG, "config init");
     xEventGroupSetBits(dev_event_group, DEVICE_CONFIG_EVENT_BIT);
-    esp_event_post_to(event_loop_hdl, DEV_EVENT, DEVICE_EVENT_CONFIG_INIT, NULL, 0, 100);
+    if (device_event_post(DEVICE_EVENT_CONFIG_INIT, NULL, 0) != ESP_OK) {
+        ESP_LOGE(TAG, "config init event dropped");
+        xEventGroupClearBits(dev_event_group, DEVICE_CONFIG_EVENT_BIT);
+        return ESP_FAIL;
+    }
     return ESP_OK;
 }
 
@@ -92,6 +241,48 @@ esp_err_t device_exit_config(void)
 
     ESP_LOGW(TAG, "config exit");
     xEventGroupClearBits(dev_event_group, DEVICE_CONFIG_EVENT_BIT);
-    esp_event_post_to(event_loop_hdl, DEV_EVENT, DEVICE_EVENT_CONFIG_EXIT, NULL, 0, 100);
+    if (device_event_post(DEVICE_EVENT_CONFIG_EXIT, NULL, 0) != ESP_OK) {
+        ESP_LOGE(TAG, "config exit event dropped");
+        xEventGroupSetBits(dev_event_group, DEVICE_CONFIG_EVENT_BIT);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+void device_notify_update(void)
+{
+    if (!update_notify_time)
+        update_notify_time = esp_timer_get_time();
+    update_seq++;
+    xEventGroupSetBits(dev_event_group, DEVICE_UPDATE_EVENT_BIT);
+}
+
+esp_err_t device_wait_update(TickType_t ticks_to_wait, int64_t *latency_us)
+{
+    EventBits_t bits;
+
+    bits = xEventGroupWaitBits(dev_event_group, DEVICE_UPDATE_EVENT_BIT, pdTRUE, pdFALSE,
+                               ticks_to_wait);
+    if (!(bits & DEVICE_UPDATE_EVENT_BIT))
+        return ESP_ERR_TIMEOUT;
+
+    if (latency_us)
+        *latency_us = update_notify_time ? esp_timer_get_time() - update_notify_time : 0;
+    update_notify_time = 0;
     return ESP_OK;
 }
+
+uint32_t device_update_seq(void)
+{
+    return update_seq;
+}
+
+void device_update_sent(uint32_t seq)
+{
+    update_sent_seq = seq;
+}
+
+bool device_update_pending(void)
+{
+    return update_sent_seq != update_seq;
+}
@@ -13,6 +13,7 @@
 #include <esp_event.h>
 #include <esp_log.h>
 #include <esp_err.h>
+#include <stdbool.h>
 
 /**
  * @brief Declare device event base
@@ -31,12 +32,310 @@ typedef enum {
     DEVICE_EVENT_CONFIG_EXIT,  /*!< config mode exit event*/
     DEVICE_EVENT_SLEEP_INIT,   /*!< sleep mode init event*/
     DEVICE_EVENT_SLEEP_RESUME, /*!< sleep mode exit event*/
+    DEVICE_EVENT_VALUE_CHANGED, /*!< channel value changed, device_channel_event_t data*/
+    DEVICE_EVENT_INPUT,         /*!< input event detected, device_channel_event_t data*/
+    DEVICE_EVENT_FAULT,         /*!< channel fault, device_channel_event_t data*/
 } device_event_id_t;
 
+/**
+ * @brief Device event priorities, high priority events are dispatched first
+ *
+ * Config, sleep and fault events are high priority,
+ * value changed and input events are normal priority.
+ */
+typedef enum {
+    DEVICE_EVENT_PRIO_NORMAL,
+    DEVICE_EVENT_PRIO_HIGH,
+    DEVICE_EVENT_PRIO_MAX
+} device_event_prio_t;
+
+#define DEVICE_EVENT_DATA_MAX 16
+#define DEVICE_EVENT_LATENCY_BUCKETS 5
+
+/**
+ * @brief Channel event data
+ *
+ */
+typedef struct {
+    void   *channel; /*!< channel publishing the event */
+    int32_t code;    /*!< value, input event or fault code */
+} device_channel_event_t;
+
+/**
+ * @brief Device event bus statistics
+ *
+ * Latency is measured from post to dispatch,
+ * histogram buckets are: <1ms, <10ms, <100ms, <1s, >=1s
+ */
+typedef struct {
+    uint32_t posted[DEVICE_EVENT_PRIO_MAX];
+    uint32_t dropped[DEVICE_EVENT_PRIO_MAX];
+    uint32_t pending[DEVICE_EVENT_PRIO_MAX];
+    uint32_t latency_max_us[DEVICE_EVENT_PRIO_MAX];
+    uint32_t latency_hist[DEVICE_EVENT_PRIO_MAX][DEVICE_EVENT_LATENCY_BUCKETS];
+} device_event_stats_t;
+
 esp_err_t   device_init(esp_event_handler_t ev_hdl, void *args);
 EventBits_t device_get_event_bits(void);
 
+/**
+ * @brief Register device event handler
+ *
+ * Handlers are called from device task in registration order,
+ * they should be registered during init.
+ *
+ * @param event_id event id or ESP_EVENT_ANY_ID
+ * @param handler event handler
+ * @param arg handler argument
+ * @return ESP_OK on success
+ */
+esp_err_t device_event_register(int32_t event_id, esp_event_handler_t handler, void *arg);
+
+/**
+ * @brief Post event to device event bus
+ *
+ * Never blocks, safe to call from esp_timer callbacks.
+ *
+ * @param event_id event id
+ * @param data event data copied into the queue, may be NULL
+ * @param size data size, up to DEVICE_EVENT_DATA_MAX
+ * @return ESP_OK on success, ESP_ERR_TIMEOUT when queue is full and event was dropped
+ */
+esp_err_t device_event_post(int32_t event_id, const void *data, size_t size);
+
+/**
+ * @brief Publish channel event (value changed, input, fault)
+ *
+ */
+esp_err_t device_publish(device_event_id_t event_id, void *channel, int32_t code);
+
+esp_err_t device_event_get_stats(device_event_stats_t *stats);
+
 esp_err_t device_init_config(void);
 esp_err_t device_exit_config(void);
 
+/**
+ * @brief Notify the supla loop that a channel value has changed
+ *
+ * Safe to call from task context, including esp_timer callbacks.
+ */
+void device_notify_update(void);
+
+/**
+ * @brief Block until device_notify_update() is called or timeout expires
+ *
+ * @param ticks_to_wait maximum time to wait
+ * @param latency_us time elapsed since first pending notification, may be NULL
+ * @return ESP_OK when notified, ESP_ERR_TIMEOUT otherwise
+ */
+esp_err_t device_wait_update(TickType_t ticks_to_wait, int64_t *latency_us);
+
+/**
+ * @brief Sequence number of last device_notify_update() call
+ *
+ */
+uint32_t device_update_seq(void);
+
+/**
+ * @brief Record that values notified up to seq were pushed to server
+ *
+ * Called by supla loop after iteration made online.
+ */
+void device_update_sent(uint32_t seq);
+
+/**
+ * @brief Check if some notified value was not pushed to server yet
+ *
+ */
+bool device_update_pending(void);
+
+/**
+ * @brief Device sleep modes, ordered from the lightest one
+ *
+ */
+typedef enum {
+    DEVICE_SLEEP_MODE_NONE,  /*!< active, no sleep */
+    DEVICE_SLEEP_MODE_MODEM, /*!< radio power save, CPU running */
+    DEVICE_SLEEP_MODE_LIGHT, /*!< CPU paused, RAM retained */
+    DEVICE_SLEEP_MODE_DEEP,  /*!< only RTC memory retained, wake up is a reset */
+    DEVICE_SLEEP_MODE_MAX
+} device_sleep_mode_t;
+
+/**
+ * @brief DEVICE_EVENT_SLEEP_INIT event data
+ *
+ */
+typedef struct {
+    device_sleep_mode_t mode;
+    int64_t             duration_us; /*!< planned sleep time, 0 when not limited */
+} device_sleep_event_t;
+
+/**
+ * @brief Time spent and estimated charge used in each sleep mode
+ *
+ * Accumulated across deep sleep cycles since power on.
+ */
+typedef struct {
+    uint64_t time_ms[DEVICE_SLEEP_MODE_MAX];
+    float    charge_mah[DEVICE_SLEEP_MODE_MAX];
+    uint32_t deep_sleep_cycles;
+} device_sleep_report_t;
+
+/**
+ * @brief Register sleep client
+ *
+ * Device enters sleep only when all clients are idle. New client is busy
+ * until device_sleep_set_deadline() is called.
+ *
+ * @param name client name
+ * @param client registered client id
+ * @return ESP_OK on success
+ */
+esp_err_t device_sleep_register(const char *name, int *client);
+
+/**
+ * @brief Mark client idle until given time
+ *
+ * @param client client id
+ * @param wake_at_us esp_timer_get_time() based deadline, 0 for no deadline
+ * @return ESP_OK on success
+ */
+esp_err_t device_sleep_set_deadline(int client, int64_t wake_at_us);
+
+/**
+ * @brief Mark client busy, leaves modem sleep if active
+ *
+ */
+esp_err_t device_sleep_set_busy(int client);
+
+/**
+ * @brief Set deepest sleep mode device may enter, DEVICE_SLEEP_MODE_NONE by default
+ *
+ */
+esp_err_t device_sleep_set_mode(device_sleep_mode_t max_mode);
+
+/**
+ * @brief Enter the deepest allowed sleep mode if all clients are idle
+ *
+ * DEVICE_EVENT_SLEEP_INIT is posted before and DEVICE_EVENT_SLEEP_RESUME
+ * after sleep. Deep sleep does not return, device resets on wake up.
+ *
+ * @return ESP_OK when sleep was requested
+ */
+esp_err_t device_sleep_enter(void);
+
+/**
+ * @brief Check if device was woken up from deep sleep
+ *
+ */
+bool device_sleep_resumed(void);
+
+/**
+ * @brief Store data in RTC memory preserved across deep sleep
+ *
+ */
+esp_err_t device_sleep_rtc_store(const void *data, size_t len);
+
+/**
+ * @brief Restore data stored before deep sleep
+ *
+ * @return ESP_ERR_NOT_FOUND when there is no data of given length
+ */
+esp_err_t device_sleep_rtc_restore(void *data, size_t len);
+
+esp_err_t device_sleep_get_report(device_sleep_report_t *report);
+
+/**
+ * @brief Power management lock types
+ *
+ */
+typedef enum {
+    DEVICE_PM_CPU_FREQ_MAX,   /*!< keep CPU at max frequency */
+    DEVICE_PM_APB_FREQ_MAX,   /*!< keep peripheral clock stable, e.g. for LEDC fades */
+    DEVICE_PM_NO_LIGHT_SLEEP, /*!< prevent automatic light sleep */
+    DEVICE_PM_LOCK_TYPE_MAX
+} device_pm_lock_type_t;
+
+typedef struct device_pm_lock *device_pm_lock_handle_t;
+
+/**
+ * @brief Time each lock type was held and average CPU frequency since boot
+ *
+ */
+typedef struct {
+    uint64_t lock_time_ms[DEVICE_PM_LOCK_TYPE_MAX];
+    uint64_t uptime_ms;
+    int      max_freq_mhz;
+    int      min_freq_mhz;
+    int      avg_freq_mhz;
+} device_pm_report_t;
+
+/**
+ * @brief Configure CPU frequency scaling
+ *
+ * CPU runs at min frequency unless some DEVICE_PM_CPU_FREQ_MAX lock is held.
+ * Uses esp_pm on ESP32 (requires CONFIG_PM_ENABLE), CPU clock switching on ESP8266.
+ * Can be called before device_init(), e.g. from board_early_init().
+ *
+ * @return ESP_OK on success, ESP_ERR_NOT_SUPPORTED when power management is disabled
+ */
+esp_err_t device_pm_configure(int max_freq_mhz, int min_freq_mhz, bool light_sleep);
+
+esp_err_t device_pm_lock_create(device_pm_lock_type_t type, const char *name,
+                                device_pm_lock_handle_t *handle);
+esp_err_t device_pm_lock_acquire(device_pm_lock_handle_t lock);
+esp_err_t device_pm_lock_release(device_pm_lock_handle_t lock);
+
+/**
+ * @brief Delete power management lock, it must not be held
+ *
+ */
+esp_err_t device_pm_lock_delete(device_pm_lock_handle_t lock);
+
+esp_err_t device_pm_get_report(device_pm_report_t *report);
+
+#define DEVICE_METRICS_CHANNELS_MAX 16
+
+/**
+ * @brief Command handling counters of single channel
+ *
+ */
+typedef struct {
+    void    *channel;
+    uint32_t set_value_count;
+    uint32_t latency_max_us; /*!< longest set_value handler run */
+    uint32_t latency_sum_us; /*!< wraps around like a counter */
+} device_channel_metrics_t;
+
+typedef struct {
+    uint32_t                 nvs_writes;
+    uint32_t                 journal_writes; /*!< position journal records */
+    uint32_t                 journal_erases; /*!< position journal sector erases */
+    int                      channels_num;
+    device_channel_metrics_t channels[DEVICE_METRICS_CHANNELS_MAX];
+} device_metrics_t;
+
+/**
+ * @brief Record set_value command handled by channel
+ *
+ * @param channel channel handle
+ * @param start_us esp_timer_get_time() taken when handler was entered
+ */
+void device_metrics_set_value(void *channel, int64_t start_us);
+
+/**
+ * @brief Count flash write of persistent channel or device state
+ *
+ */
+void device_metrics_nvs_write(void);
+
+/**
+ * @brief Count record appended to position journal and journal sector erase
+ *
+ */
+void device_metrics_journal_write(void);
+void device_metrics_journal_erase(void);
+
+esp_err_t device_metrics_get(device_metrics_t *metrics);
+
 #endif /* MAIN_DEVICE_H_ */
@@ -8,6 +8,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <esp_timer.h>
+#include <device.h>
 
 #define DEFAULT_POLL_INTERVAL_MS 1000 //1000ms
 
@@ -20,6 +21,7 @@ struct sensor_nvs_config {
 
 struct sensor_data {
     gpio_num_t               gpio;
+    int                      level;
     esp_timer_handle_t       timer;
     struct sensor_nvs_config nvs_config;
 };
@@ -53,6 +55,7 @@ static int supla_srv_binary_sensor_config(supla_channel_t *ch, TSD_ChannelConfig
         data->nvs_config.active_func = config->Func;
         data->nvs_config.bin_sensor = *sensor_conf;
         supla_esp_nvs_channel_state_store(ch, &data->nvs_config, sizeof(data->nvs_config));
+        device_metrics_nvs_write();
 
         if (sensor_conf->FilteringTimeMs) {
             esp_timer_stop(data->timer);
@@ -70,6 +73,11 @@ static void input_poll(void *arg)
     const int           inv_logic = data->nvs_config.bin_sensor.InvertedLogic;
 
     supla_channel_set_binary_value(ch, inv_logic ? !level : level);
+    if (level != data->level) {
+        data->level = level;
+        device_publish(DEVICE_EVENT_INPUT, ch, level);
+        device_notify_update();
+    }
 }
 
 supla_channel_t *supla_binary_sensor_create(const struct binary_sensor_config *config)
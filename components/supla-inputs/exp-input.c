@@ -13,6 +13,7 @@
 #include <string.h>
 #include <esp_timer.h>
 #include <esp_log.h>
+#include <device.h>
 
 #define EXP_POLL_INTERVAL_US 100000 //100ms
 
@@ -82,6 +83,10 @@ static void exp_input_poll(void *arg)
     default:
         break;
     }
+    if (event != EXP_INPUT_EVENT_NONE) {
+        device_publish(DEVICE_EVENT_INPUT, ch, event);
+        device_notify_update();
+    }
     data->prev_level = level;
 }
 
@@ -9,6 +9,7 @@
 #include <string.h>
 #include <esp_timer.h>
 #include <esp_log.h>
+#include <device.h>
 
 #define EXP_POLL_INTERVAL_US 100000 //100ms
 #define DEAD_TIME_US 100000         //100ms
@@ -90,8 +91,11 @@ static void input_poll(void *arg)
             data->hold_sent = 1;
             reset_click_buffer(data);
             data->on_detect_cb(data->gpio, INPUT_EVENT_HOLD, data->cb_arg);
-            if (ch_config.action_trigger_caps & SUPLA_ACTION_CAP_HOLD)
+            device_publish(DEVICE_EVENT_INPUT, ch, INPUT_EVENT_HOLD);
+            if (ch_config.action_trigger_caps & SUPLA_ACTION_CAP_HOLD) {
                 supla_channel_emit_action(ch, SUPLA_ACTION_CAP_HOLD);
+                device_notify_update();
+            }
         }
     } else {
         if (press_time > 0 && !data->hold_sent) {
@@ -118,8 +122,11 @@ static void input_poll(void *arg)
         }
         if (valid_clicks) {
             data->on_detect_cb(data->gpio, valid_clicks, data->cb_arg);
-            if (ch_config.action_trigger_caps & click_actions[valid_clicks])
+            device_publish(DEVICE_EVENT_INPUT, ch, valid_clicks);
+            if (ch_config.action_trigger_caps & click_actions[valid_clicks]) {
                 supla_channel_emit_action(ch, click_actions[valid_clicks]);
+                device_notify_update();
+            }
         }
         reset_click_buffer(data);
         data->on_detect_cb(data->gpio, INPUT_EVENT_DONE, data->cb_arg);
@@ -21,6 +21,8 @@ struct rs_channel_config {
     gpio_num_t   gpio_close;
     unsigned int supported_functions; //SUPLA_BIT_FUNC_*
     int          default_function;    //SUPLA_CHANNELFNC_*
+    uint16_t     start_delay_ms;      //motor starts this long after output is on
+    uint16_t     run_on_ms;           //motor stops this long after output is off
 };
 
 supla_channel_t *supla_rs_channel_create(const struct rs_channel_config *config);
@@ -33,5 +35,14 @@ int supla_rs_channel_move_down_or_stop(supla_channel_t *ch);
 int supla_rs_channel_move_up_or_stop(supla_channel_t *ch);
 int supla_rs_channel_step_by_step(supla_channel_t *ch);
 int supla_rs_channel_set_target_position(supla_channel_t *ch, int8_t target);
+int supla_rs_channel_set_target_tilt(supla_channel_t *ch, int8_t tilt);
+int supla_rs_channel_set_target(supla_channel_t *ch, int8_t target, int8_t tilt); //-1: keep
+
+/**
+ * @brief Compensate relay latency and motor inertia
+ *
+ * Both are applied to position estimate and to stop time of each move.
+ */
+int supla_rs_channel_set_motor_timing(supla_channel_t *ch, int start_delay_ms, int run_on_ms);
 
 #endif /* _SUPLA_RELAY_CHANNEL_H_ */
@@ -9,6 +9,7 @@
 #include <esp_log.h>
 #include <esp_timer.h>
 #include <esp-supla.h>
+#include <device.h>
 
 static const char *TAG = "BLE-CH";
 
@@ -21,8 +22,21 @@ struct lamp_ble_channel_data {
     struct lamp_ble_nvs_state      nvs_state;
     lampsmart_ble_t                light;
     TRGBW_Value                   *value;
+    esp_timer_handle_t             tx_timer;
+    device_pm_lock_handle_t        pm_lock;
+    bool                           pm_locked;
 };
 
+static void tx_done(void *arg)
+{
+    struct lamp_ble_channel_data *data = arg;
+
+    if (data->pm_locked) {
+        data->pm_locked = false;
+        device_pm_lock_release(data->pm_lock);
+    }
+}
+
 static const char *variant_name(lampsmart_variant_t variant)
 {
     switch (variant) {
@@ -64,6 +78,7 @@ static int lamp_ble_channel_on_cfg_recv(supla_channel_t *ch, TSD_ChannelConfig *
     case SUPLA_CHANNELFNC_DIMMER_CCT:
         data->nvs_state.active_func = config->Func;
         supla_esp_nvs_channel_state_store(ch, &data->nvs_state, sizeof(data->nvs_state));
+        device_metrics_nvs_write();
         break;
     default:
         break;
@@ -74,6 +89,7 @@ static int lamp_ble_channel_on_cfg_recv(supla_channel_t *ch, TSD_ChannelConfig *
 int lamp_ble_channel_set_value(supla_channel_t *ch, TSD_SuplaChannelNewValue *new_value)
 {
     struct lamp_ble_channel_data *data = supla_channel_get_data(ch);
+    const int64_t                 start_us = esp_timer_get_time();
 
     const int ch_num = supla_channel_get_assigned_number(ch);
     const int active_func = data->nvs_state.active_func;
@@ -84,11 +100,20 @@ int lamp_ble_channel_set_value(supla_channel_t *ch, TSD_SuplaChannelNewValue *ne
     uint8_t br = rgbw->brightness;
     uint8_t wt = rgbw->whiteTemperature;
     uint8_t cold, warm;
+    int     rc;
 
     if (data->config.relay_gpio != GPIO_NUM_NC) {
         gpio_set_level(data->config.relay_gpio, br > 0 ? 1 : 0);
     }
 
+    // keep CPU at full speed for advertising burst
+    esp_timer_stop(data->tx_timer);
+    if (!data->pm_locked) {
+        data->pm_locked = true;
+        device_pm_lock_acquire(data->pm_lock);
+    }
+    esp_timer_start_once(data->tx_timer, data->config.lamp_config.tx_duration_ms * 1000);
+
     switch (active_func) {
     case SUPLA_CHANNELFNC_DIMMER: {
         uint8_t val = (uint16_t)br * 255 / 100;
@@ -115,7 +140,10 @@ int lamp_ble_channel_set_value(supla_channel_t *ch, TSD_SuplaChannelNewValue *ne
     default:
         break;
     }
-    return supla_channel_set_rgbw_value(ch, rgbw);
+    rc = supla_channel_set_rgbw_value(ch, rgbw);
+    device_notify_update();
+    device_metrics_set_value(ch, start_us);
+    return rc;
 }
 
 int lamp_ble_channel_get_value(supla_channel_t *ch, TRGBW_Value *value)
@@ -151,10 +179,24 @@ supla_channel_t *lamp_ble_channel_create(const struct lamp_ble_channel_config *c
         return NULL;
     }
 
+    esp_timer_create_args_t timer_args = {
+        .name = "ble-tx",
+        .dispatch_method = ESP_TIMER_TASK,
+        .callback = tx_done,
+        .arg = data,
+    };
+
     data->config = *conf;
+    data->tx_timer = NULL;
+    data->pm_lock = NULL;
+    data->pm_locked = false;
     supla_channel_set_data(ch, data);
+    esp_timer_create(&timer_args, &data->tx_timer);
+    device_pm_lock_create(DEVICE_PM_CPU_FREQ_MAX, "ble-tx", &data->pm_lock);
 
     if (lampsmart_ble_init(&data->light, &data->config.lamp_config) != ESP_OK) {
+        esp_timer_delete(data->tx_timer);
+        device_pm_lock_delete(data->pm_lock);
         supla_channel_free(ch);
         free(data);
         return NULL;
@@ -8,16 +8,30 @@
 #include <stdlib.h>
 #include <esp_log.h>
 #include <esp_timer.h>
+#include <device.h>
 
 struct ledc_channel_data {
-    ledc_channel_config_t ledc;
-    uint8_t               brightness;
-    uint8_t               base_brightness;
-    uint32_t              fade_time;
-    uint32_t              duty_res;
-    esp_timer_handle_t    timer;
+    ledc_channel_config_t   ledc;
+    uint8_t                 brightness;
+    uint8_t                 base_brightness;
+    uint32_t                fade_time;
+    uint32_t                duty_res;
+    esp_timer_handle_t      timer;
+    esp_timer_handle_t      fade_timer;
+    device_pm_lock_handle_t pm_lock;
+    bool                    pm_locked;
 };
 
+static void fade_done(void *arg)
+{
+    struct ledc_channel_data *data = arg;
+
+    if (data->pm_locked) {
+        data->pm_locked = false;
+        device_pm_lock_release(data->pm_lock);
+    }
+}
+
 static void deferred_fade_out(void *ch)
 {
     TSD_SuplaChannelNewValue  new_value = {};
@@ -32,16 +46,27 @@ int ledc_dimmer_set_brightness(supla_channel_t *ch, TSD_SuplaChannelNewValue *ne
     struct ledc_channel_data *data = supla_channel_get_data(ch);
     TRGBW_Value              *rgbw = (TRGBW_Value *)new_value->value;
     uint32_t                  duty = (rgbw->brightness * data->duty_res) / 100;
+    int                       rc;
+
     data->brightness = rgbw->brightness;
 
     esp_timer_stop(data->timer);
+    // hold clock stable until fade ends, lock is already taken when previous fade is running
+    esp_timer_stop(data->fade_timer);
+    if (!data->pm_locked) {
+        data->pm_locked = true;
+        device_pm_lock_acquire(data->pm_lock);
+    }
+    esp_timer_start_once(data->fade_timer, data->fade_time * 1000);
     ledc_set_fade_with_time(data->ledc.speed_mode, data->ledc.channel, duty, data->fade_time);
     ledc_fade_start(data->ledc.speed_mode, data->ledc.channel, LEDC_FADE_NO_WAIT);
 
     if (new_value->DurationMS)
         esp_timer_start_once(data->timer, new_value->DurationMS * 1000);
 
-    return supla_channel_set_rgbw_value(ch, rgbw);
+    rc = supla_channel_set_rgbw_value(ch, rgbw);
+    device_notify_update();
+    return rc;
 }
 
 int ledc_dimmer_get_brightness(supla_channel_t *ch, uint8_t *brightness)
@@ -59,9 +84,13 @@ int ledc_dimmer_set_base_brightness(supla_channel_t *ch, TSD_SuplaChannelNewValu
 {
     struct ledc_channel_data *data = supla_channel_get_data(ch);
     TRGBW_Value              *rgbw = (TRGBW_Value *)new_value->value;
-    data->base_brightness = rgbw->brightness;
+    const int64_t             start_us = esp_timer_get_time();
+    int                       rc;
 
-    return ledc_dimmer_set_brightness(ch, new_value);
+    data->base_brightness = rgbw->brightness;
+    rc = ledc_dimmer_set_brightness(ch, new_value);
+    device_metrics_set_value(ch, start_us);
+    return rc;
 }
 
 int ledc_dimmer_get_base_brightness(supla_channel_t *ch, uint8_t *brightness)
@@ -95,6 +124,11 @@ supla_channel_t *ledc_dimmer_channel_create(const struct ledc_channel_config *le
         .dispatch_method = ESP_TIMER_TASK,
         .callback = deferred_fade_out,
     };
+    esp_timer_create_args_t fade_timer_args = {
+        .name = "ledc-fade",
+        .dispatch_method = ESP_TIMER_TASK,
+        .callback = fade_done,
+    };
     struct ledc_channel_data *data;
 
     supla_channel_t *ch = supla_channel_create(&dimmer_channel_config);
@@ -121,5 +155,8 @@ supla_channel_t *ledc_dimmer_channel_create(const struct ledc_channel_config *le
     ledc_fade_func_install(0);
     timer_args.arg = ch;
     esp_timer_create(&timer_args, &data->timer);
+    fade_timer_args.arg = data;
+    esp_timer_create(&fade_timer_args, &data->fade_timer);
+    device_pm_lock_create(DEVICE_PM_APB_FREQ_MAX, "ledc", &data->pm_lock);
     return ch;
 }
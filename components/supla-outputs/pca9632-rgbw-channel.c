@@ -11,6 +11,7 @@
 #include <esp_log.h>
 #include <esp_timer.h>
 #include <esp-supla.h>
+#include <device.h>
 
 #define CHANNEL_MUTEX_TIMEOUT 1000 //ms
 
@@ -80,6 +81,7 @@ static int pca9632_channel_on_cfg_recv(supla_channel_t *ch, TSD_ChannelConfig *c
     case SUPLA_CHANNELFNC_DIMMER_CCT_AND_RGB:
         data->nvs_state.active_func = config->Func;
         supla_esp_nvs_channel_state_store(ch, &data->nvs_state, sizeof(data->nvs_state));
+        device_metrics_nvs_write();
         break;
     default:
         break;
@@ -102,6 +104,8 @@ int pca9632_channel_set_value(supla_channel_t *ch, TSD_SuplaChannelNewValue *new
     TRGBW_Value         *rgbw = (TRGBW_Value *)new_value->value;
     struct channel_data *ch_data;
     const int            ch_num = supla_channel_get_assigned_number(ch);
+    const int64_t        start_us = esp_timer_get_time();
+    int                  rc;
 
     ESP_LOGI(TAG, "ch[%d] val: BR=%d CB=%d R=%d G=%d B=%d WT=%d", ch_num, rgbw->brightness,
              rgbw->colorBrightness, rgbw->R, rgbw->G, rgbw->B, rgbw->whiteTemperature);
@@ -115,7 +119,10 @@ int pca9632_channel_set_value(supla_channel_t *ch, TSD_SuplaChannelNewValue *new
     ch_data->rgbw_target = *rgbw;
     CHANNEL_SEMAPHORE_GIVE(ch_data->mutex);
 
-    return supla_channel_set_rgbw_value(ch, rgbw);
+    rc = supla_channel_set_rgbw_value(ch, rgbw);
+    device_notify_update();
+    device_metrics_set_value(ch, start_us);
+    return rc;
 }
 
 static esp_err_t pca9632_set_rgbw_value(struct channel_data *ch_data)
@@ -11,6 +11,7 @@
 #include <esp_timer.h>
 #include <esp-supla.h>
 #include <driver/gpio.h>
+#include <device.h>
 
 static const char *TAG = "RELAY-CH";
 
@@ -70,6 +71,7 @@ static int supla_srv_relay_config(supla_channel_t *ch, TSD_ChannelConfig *config
             data->nvs_state.active_func = config->Func;
             data->nvs_state.pwr_switch_conf = *switch_conf;
             supla_esp_nvs_channel_state_store(ch, &data->nvs_state, sizeof(data->nvs_state));
+            device_metrics_nvs_write();
         }
     } break;
     case SUPLA_CHANNELFNC_STAIRCASETIMER: {
@@ -81,6 +83,7 @@ static int supla_srv_relay_config(supla_channel_t *ch, TSD_ChannelConfig *config
             data->nvs_state.active_func = config->Func;
             data->nvs_state.staircase_conf = *staircase_conf;
             supla_esp_nvs_channel_state_store(ch, &data->nvs_state, sizeof(data->nvs_state));
+            device_metrics_nvs_write();
         }
     } break;
     default:
@@ -95,6 +98,8 @@ static int supla_relay_channel_set(supla_channel_t *ch, TSD_SuplaChannelNewValue
     TTimerState_ExtendedValue  timer_state = {};
     const int                  ch_num = supla_channel_get_assigned_number(ch);
     struct relay_channel_data *data = supla_channel_get_data(ch);
+    const int64_t              start_us = esp_timer_get_time();
+    int                        rc;
 
     esp_timer_stop(data->timer);
     data->mseconds_left = relay_val->hi ? (new_value->DurationMS) : 0;
@@ -111,7 +116,11 @@ static int supla_relay_channel_set(supla_channel_t *ch, TSD_SuplaChannelNewValue
     } else {
         ESP_LOGI(TAG, "ch[%d] set %s", ch_num, relay_val->hi ? "ON" : "OFF");
     }
-    return supla_channel_set_relay_value(ch, relay_val);
+    rc = supla_channel_set_relay_value(ch, relay_val);
+    device_publish(DEVICE_EVENT_VALUE_CHANGED, ch, relay_val->hi);
+    device_notify_update();
+    device_metrics_set_value(ch, start_us);
+    return rc;
 }
 
 static void countdown_timer_event(void *ch)
@@ -9,6 +9,7 @@
 #include <esp_log.h>
 #include <esp_timer.h>
 #include <esp-supla.h>
+#include <device.h>
 
 static const char *TAG = "RGBW-CH";
 
@@ -56,6 +57,7 @@ static int rgbw_channel_on_cfg_recv(supla_channel_t *ch, TSD_ChannelConfig *conf
     case SUPLA_CHANNELFNC_DIMMER_CCT_AND_RGB:
         data->nvs_state.active_func = config->Func;
         supla_esp_nvs_channel_state_store(ch, &data->nvs_state, sizeof(data->nvs_state));
+        device_metrics_nvs_write();
         break;
     default:
         break;
@@ -73,6 +75,8 @@ int rgbw_channel_set_value(supla_channel_t *ch, TSD_SuplaChannelNewValue *new_va
     uint32_t r, g, b, w, cb, wt;
     uint32_t cold, warm;
     uint32_t f = conf->fade_time;
+    int64_t  start_us = esp_timer_get_time();
+    int      rc;
 
     supla_log(LOG_INFO, "new RGBW val: R=%d G=%d B=%d CB=%d W=%d", rgbw->R, rgbw->G, rgbw->B,
               rgbw->colorBrightness, rgbw->brightness);
@@ -155,7 +159,10 @@ int rgbw_channel_set_value(supla_channel_t *ch, TSD_SuplaChannelNewValue *new_va
         break;
     }
 
-    return supla_channel_set_rgbw_value(ch, rgbw);
+    rc = supla_channel_set_rgbw_value(ch, rgbw);
+    device_notify_update();
+    device_metrics_set_value(ch, start_us);
+    return rc;
 }
 
 supla_channel_t *rgbw_channel_create(const struct rgbw_channel_config *conf)
@@ -5,12 +5,17 @@
  */
 
 #include "include/rs-channel.h"
+#include "rs-journal.h"
+#include "rs-motion.h"
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
+#include <sys/param.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/semphr.h>
 #include <esp_log.h>
 #include <esp_timer.h>
+#include <device.h>
 
 #define CHANNEL_SEMAPHORE_TAKE(mutex)                      \
     do {                                                   \
@@ -28,16 +33,25 @@
         }                                      \
     } while (0)
 
-#define RS_TIMER_INTERVAL 100   //ms
-#define RS_REPORT_INTERVAL 500  //ms
-#define RS_STORE_INTERVAL 10000 //ms
+#define RS_REPORT_INTERVAL 500   //ms
+#define RS_STORE_INTERVAL 10000  //ms, NVS store when position journal is not available
+#define RS_JOURNAL_INTERVAL 1000 //ms, position checkpoint while moving
+#define RS_CALIBRATION_MARGIN 10 //% of full travel time added to calibration runs
+#define RS_REVERSE_DEAD_TIME 300 //ms, pause after run-on before motor turns back
+
+#ifdef CONFIG_IDF_TARGET_ESP8266
+// esp_timer is based on RTOS ticks here, stop in the tick nearest to deadline
+#define RS_TIMER_SLACK_US (portTICK_PERIOD_MS * 500)
+#else
+#define RS_TIMER_SLACK_US 100
+#endif
 
 static const char *TAG = "RS-CH";
-enum rs_state { RS_STATE_OPENING = -1, RS_STATE_IDLE = 0, RS_STATE_CLOSING = 1 };
 
 struct rs_nvs_state {
     int    active_func;
     int8_t stored_pos;
+    int8_t stored_tilt; // fits in padding, older records read 0
     union {
         TChannelConfig_RollerShutter rs_conf;
         TChannelConfig_FacadeBlind   blinds_conf;
@@ -45,18 +59,22 @@ struct rs_nvs_state {
 };
 
 struct rs_channel_data {
-    SemaphoreHandle_t   mutex;
-    gpio_num_t          gpio_open;
-    gpio_num_t          gpio_close;
-    enum rs_state       state;
-    enum rs_state       last_state;
-    bool                calibration;
-    float               real_pos;   // 0 - closed; 100 - opened
-    int8_t              target_pos; // 0 - closed; 100 - opened
-    TickType_t          report_tick;
-    TickType_t          store_tick;
-    esp_timer_handle_t  timer;
-    struct rs_nvs_state nvs_state;
+    SemaphoreHandle_t       mutex;
+    gpio_num_t              gpio_open;
+    gpio_num_t              gpio_close;
+    struct rs_motion        motion; // times are esp_timer times
+    enum rs_state           last_state;
+    bool                    calibration;
+    int64_t                 deadline_us;   // esp_timer time when outputs of current move are off
+    int64_t                 stop_us;       // esp_timer time when outputs were switched off
+    bool                    move_pending;  // move is started by timer after reversal dead time
+    bool                    journal;       // position kept in journal, not in NVS
+    int64_t                 journal_at_us; // esp_timer time of last journal record
+    bool                    store_pending;
+    esp_timer_handle_t      timer; // one-shot: move deadline, report, reversal, nvs store
+    struct rs_nvs_state     nvs_state;
+    device_pm_lock_handle_t pm_lock;
+    bool                    pm_locked;
 };
 
 static int supla_rs_channel_get_base_function(supla_channel_t *ch)
@@ -116,86 +134,330 @@ static int supla_rs_channel_get_closing_time(supla_channel_t *ch)
     }
 }
 
-//static int supla_rs_channel_get_tilting_time(supla_channel_t *ch)
-//{
-//    struct rs_channel_data *data = supla_channel_get_data(ch);
-//    struct rs_nvs_state    *conf = &data->nvs_state;
-//    const int               base_func = supla_rs_channel_get_base_function(ch);
-//
-//    switch (base_func) {
-//    case SUPLA_CHANNELFNC_CONTROLLINGTHEROLLERSHUTTER:
-//        return 0;
-//    case SUPLA_CHANNELFNC_CONTROLLINGTHEFACADEBLIND:
-//        return conf->blinds_conf.TiltingTimeMS;
-//    default:
-//        return 0;
-//    }
-//}
+static int supla_rs_channel_get_tilting_time(supla_channel_t *ch)
+{
+    struct rs_channel_data *data = supla_channel_get_data(ch);
+    struct rs_nvs_state    *conf = &data->nvs_state;
+    const int               base_func = supla_rs_channel_get_base_function(ch);
+
+    switch (base_func) {
+    case SUPLA_CHANNELFNC_CONTROLLINGTHEROLLERSHUTTER:
+        return 0;
+    case SUPLA_CHANNELFNC_CONTROLLINGTHEFACADEBLIND:
+        return conf->blinds_conf.TiltingTimeMS;
+    default:
+        return 0;
+    }
+}
+
+static int supla_rs_channel_get_full_time(supla_channel_t *ch, enum rs_state state)
+{
+    return (state == RS_STATE_CLOSING) ? supla_rs_channel_get_closing_time(ch) :
+                                         supla_rs_channel_get_opening_time(ch);
+}
+
+static void supla_rs_channel_timer_arm(struct rs_channel_data *data, int64_t timeout_us)
+{
+    esp_timer_stop(data->timer); // may not be running
+    esp_timer_start_once(data->timer, timeout_us > 0 ? timeout_us : 0);
+}
+
+static void supla_rs_channel_report(supla_channel_t *ch)
+{
+    struct rs_channel_data *data = supla_channel_get_data(ch);
+    const int               ch_num = supla_channel_get_assigned_number(ch);
+    float                   pos, tilt;
+    int8_t                  position;
+
+    rs_motion_position(&data->motion,
+                       rs_motion_run_time(&data->motion, esp_timer_get_time(), false), &pos, &tilt);
+    position = (!data->calibration) ? lroundf(pos) : -1; // -1: calibration needed
+
+    if (data->motion.state != RS_STATE_IDLE) {
+        supla_log(LOG_INFO, "ch[%d] rs: %s position=%d tilt=%d target=%d/%d last state=%d",
+                  ch_num, data->motion.state == RS_STATE_OPENING ? "OPENING" : "CLOSING", position,
+                  (int)lroundf(tilt), data->motion.target_pos, data->motion.target_tilt,
+                  data->last_state);
+    }
+
+    switch (supla_rs_channel_get_base_function(ch)) {
+    case SUPLA_CHANNELFNC_CONTROLLINGTHEROLLERSHUTTER: {
+        TDSC_RollerShutterValue rs_val = {
+            .position = position,
+        };
+        if (data->calibration && data->motion.state != RS_STATE_IDLE)
+            rs_val.flags |= RS_VALUE_FLAG_CALIBRATION_IN_PROGRESS;
+
+        supla_channel_set_roller_shutter_value(ch, &rs_val);
+    } break;
+    case SUPLA_CHANNELFNC_CONTROLLINGTHEFACADEBLIND: {
+        TDSC_FacadeBlindValue fb_val = {
+            .position = position,
+            .tilt = lroundf(tilt),
+        };
+        if (!data->calibration)
+            fb_val.flags |= RS_VALUE_FLAG_TILT_IS_SET;
+        if (data->calibration && data->motion.state != RS_STATE_IDLE)
+            fb_val.flags |= RS_VALUE_FLAG_CALIBRATION_IN_PROGRESS;
+
+        supla_channel_set_facadeblind_value(ch, &fb_val);
+    } break;
+    default:
+        return;
+    }
+    device_notify_update();
+}
+
+/*
+ * Record current position: stop record when idle, checkpoint when moving.
+ * Position is unknown until calibration is done.
+ */
+static void supla_rs_channel_journal(supla_channel_t *ch)
+{
+    struct rs_channel_data *data = supla_channel_get_data(ch);
+    const int64_t           now = esp_timer_get_time();
+    float                   pos, tilt;
+
+    if (!data->journal)
+        return;
+
+    rs_motion_position(&data->motion, rs_motion_run_time(&data->motion, now, false), &pos, &tilt);
+    if (data->calibration)
+        pos = tilt = RS_JOURNAL_POS_UNKNOWN;
+    rs_journal_write(supla_channel_get_assigned_number(ch),
+                     data->motion.state == RS_STATE_IDLE ? RS_JOURNAL_STOP : RS_JOURNAL_MOVE,
+                     lroundf(pos), lroundf(tilt));
+    data->journal_at_us = now;
+}
 
 static int supla_rs_channel_init(supla_channel_t *ch)
 {
     struct rs_channel_data *data = supla_channel_get_data(ch);
     const int               ch_num = supla_channel_get_assigned_number(ch);
+    int8_t                  pos, tilt;
+    bool                    moving;
     esp_err_t               rc;
 
     supla_log(LOG_INFO, "ch[%d] rs_ch init", ch_num);
     CHANNEL_SEMAPHORE_TAKE(data->mutex);
-    data->real_pos = -1; //need calibration if not read correctly from nvs
+    data->motion.real_pos = -1; //need calibration if not read correctly from nvs
     rc = supla_esp_nvs_channel_state_restore(ch, &data->nvs_state, sizeof(data->nvs_state));
     if (rc == ESP_OK) {
         supla_log(LOG_INFO, "ch[%d] rs_ch nvs read OK:func=%d pos=%d", ch_num,
                   data->nvs_state.active_func, data->nvs_state.stored_pos);
 
         supla_channel_set_active_function(ch, data->nvs_state.active_func);
-        data->real_pos = data->nvs_state.stored_pos;
-        data->target_pos = data->real_pos;
+        data->motion.real_pos = data->nvs_state.stored_pos;
+        data->motion.real_tilt = data->nvs_state.stored_tilt;
+        data->motion.target_pos = data->motion.real_pos;
+    }
+    // journal is newer than NVS unless it was just created
+    data->journal = rs_journal_init() == ESP_OK;
+    rc = data->journal ? rs_journal_restore(ch_num, &pos, &tilt, &moving) : ESP_ERR_NOT_FOUND;
+    if (rc == ESP_OK) {
+        supla_log(moving ? LOG_WARNING : LOG_INFO, "ch[%d] rs_ch journal read OK:pos=%d tilt=%d%s",
+                  ch_num, pos, tilt, moving ? " - power lost while moving" : "");
+        data->motion.real_pos = pos;
+        data->motion.real_tilt = MAX(tilt, 0);
+        data->motion.target_pos = data->motion.real_pos;
     }
     //enable calibration if position is unknown
-    if (data->real_pos < 0) {
+    if (data->motion.real_pos < 0) {
         supla_log(LOG_WARNING, "ch[%d] rs_ch needs calibration", ch_num);
         data->calibration = true;
     }
+    if (data->journal && rc != ESP_OK)
+        supla_rs_channel_journal(ch); // first record, position taken from NVS
+    supla_rs_channel_report(ch);
     CHANNEL_SEMAPHORE_GIVE(data->mutex);
     return SUPLA_RESULTCODE_TRUE;
 }
 
-static int supla_rs_channel_internal_stop(supla_channel_t *ch)
+/*
+ * Stop outputs and fix position at current time. Calibration completes only
+ * when whole calibration run was made, i.e. move deadline was reached.
+ */
+static int supla_rs_channel_internal_stop(supla_channel_t *ch, bool reached)
 {
     struct rs_channel_data *data = supla_channel_get_data(ch);
+    const int64_t           now = esp_timer_get_time();
 
-    if (data->state != RS_STATE_IDLE) {
-        data->last_state = data->state;
-        switch (data->last_state) {
-        case RS_STATE_CLOSING:
-            //calibration completed
-            if (data->calibration && data->target_pos == 100) {
-                data->calibration = false;
-                data->real_pos = 100;
-            }
-            break;
-        case RS_STATE_OPENING:
-            //calibration completed
-            if (data->calibration && data->target_pos == 0) {
-                data->calibration = false;
-                data->real_pos = 0;
-            }
-            break;
-        default:
-            break;
+    gpio_set_level(data->gpio_open, 0);
+    gpio_set_level(data->gpio_close, 0);
+    data->move_pending = false;
+    if (data->motion.state != RS_STATE_IDLE) {
+        data->stop_us = now;
+        rs_motion_position(&data->motion, rs_motion_run_time(&data->motion, now, true),
+                           &data->motion.real_pos, &data->motion.real_tilt);
+        data->last_state = data->motion.state;
+        if (data->calibration && reached) {
+            data->calibration = false;
+            data->motion.real_pos = (data->last_state == RS_STATE_CLOSING) ? 100 : 0;
+            data->motion.real_tilt = data->motion.real_pos;
+        }
+        data->motion.state = RS_STATE_IDLE;
+        if (data->journal) {
+            supla_rs_channel_journal(ch);
+        } else {
+            data->store_pending = true;
+            supla_rs_channel_timer_arm(data, RS_STORE_INTERVAL * 1000LL);
         }
+        supla_rs_channel_report(ch);
+    }
+    if (!reached) {
+        data->motion.target_pos = lroundf(data->motion.real_pos);
+        data->motion.target_tilt = -1;
     }
 
-    data->state = RS_STATE_IDLE;
-    data->target_pos = data->real_pos;
-    gpio_set_level(data->gpio_open, 0);
-    gpio_set_level(data->gpio_close, 0);
+    if (data->pm_locked) {
+        data->pm_locked = false;
+        device_pm_lock_release(data->pm_lock);
+    }
     return ESP_OK;
 }
 
+/*
+ * Motor run time needed to reach target position and tilt, 0 when reached.
+ * Position is reached first with slats turned in direction of move, then
+ * slats are turned back. Moves shorter than half of run-on are not made.
+ */
+static int64_t supla_rs_channel_plan(supla_channel_t *ch, float pos, float tilt,
+                                     enum rs_state *state)
+{
+    struct rs_channel_data      *data = supla_channel_get_data(ch);
+    const struct rs_motion_times times = {
+        .opening_ms = supla_rs_channel_get_opening_time(ch),
+        .closing_ms = supla_rs_channel_get_closing_time(ch),
+        .tilting_ms = supla_rs_channel_get_tilting_time(ch),
+    };
+
+    return rs_motion_plan(&data->motion, &times, pos, tilt,
+                          MAX(data->motion.run_on_us / 2, RS_TIMER_SLACK_US), state);
+}
+
+/*
+ * Motor has to stop before it turns back: outputs go off and move in state
+ * direction is made by timer once run-on and dead time passed.
+ */
+static bool supla_rs_channel_reverse_wait(supla_channel_t *ch, enum rs_state state)
+{
+    struct rs_channel_data *data = supla_channel_get_data(ch);
+    const int8_t            target_pos = data->motion.target_pos;
+    const int8_t            target_tilt = data->motion.target_tilt;
+    int64_t                 wait_us;
+
+    if (data->motion.state == state)
+        return false;
+    if (data->motion.state != RS_STATE_IDLE) {
+        supla_rs_channel_internal_stop(ch, false);
+        data->motion.target_pos = target_pos; // not a stop command, target is kept
+        data->motion.target_tilt = target_tilt;
+    }
+    if (data->last_state == state)
+        return false;
+
+    wait_us = data->stop_us + data->motion.run_on_us + RS_REVERSE_DEAD_TIME * 1000LL -
+              esp_timer_get_time();
+    if (wait_us <= 0)
+        return false;
+
+    data->move_pending = true;
+    supla_rs_channel_timer_arm(data, wait_us);
+    return true;
+}
+
+/*
+ * Start next move towards target position and tilt: outputs are switched at
+ * once and one-shot timer is armed for exact stop time. Outputs go off before
+ * target by motor run-on, start delay is added unless motor already runs in
+ * this direction. Position unknown before calibration, so whole way to the
+ * end nearer to target is made first.
+ */
+static void supla_rs_channel_move(supla_channel_t *ch)
+{
+    struct rs_channel_data *data = supla_channel_get_data(ch);
+    const int64_t           now = esp_timer_get_time();
+    const int               tilting_ms = supla_rs_channel_get_tilting_time(ch);
+    enum rs_state           state = RS_STATE_IDLE;
+    float                   pos, tilt;
+    int                     full_ms;
+    int64_t                 run_us, delay_us;
+
+    rs_motion_position(&data->motion, rs_motion_run_time(&data->motion, now, false), &pos, &tilt);
+    if (data->calibration) {
+        if (data->motion.target_pos >= 0)
+            state = (data->motion.target_pos >= 50) ? RS_STATE_CLOSING : RS_STATE_OPENING;
+        else
+            state = (data->motion.target_tilt >= 50) ? RS_STATE_CLOSING : RS_STATE_OPENING;
+        if (data->motion.state == state)
+            return; // calibration run in progress, target is taken after it
+
+        full_ms = supla_rs_channel_get_full_time(ch, state);
+        if (!full_ms) {
+            supla_rs_channel_internal_stop(ch, false); // not configured yet
+            return;
+        }
+        if (supla_rs_channel_reverse_wait(ch, state))
+            return;
+        pos = (state == RS_STATE_CLOSING) ? 0 : 100;
+        tilt = pos;
+        run_us = (full_ms + tilting_ms) * (100LL + RS_CALIBRATION_MARGIN) * 10;
+    } else {
+        run_us = supla_rs_channel_plan(ch, pos, tilt, &state);
+        if (!run_us) {
+            supla_rs_channel_internal_stop(ch, true); // target reached
+            return;
+        }
+        if (supla_rs_channel_reverse_wait(ch, state))
+            return; // position with motor coast is replanned after dead time
+        full_ms = supla_rs_channel_get_full_time(ch, state);
+        run_us = MAX(run_us - data->motion.run_on_us, 1);
+    }
+
+    if (data->motion.state == state)
+        delay_us = MAX(data->motion.move_start_us + data->motion.move_delay_us - now, 0);
+    else
+        delay_us = data->motion.start_delay_us;
+
+    data->motion.real_pos = pos;
+    data->motion.real_tilt = tilt;
+    data->motion.move_start_us = now;
+    data->motion.move_delay_us = delay_us;
+    data->motion.move_full_us = full_ms * 1000LL;
+    data->motion.tilt_full_us = tilting_ms * 1000LL;
+    data->deadline_us = now + delay_us + run_us;
+    if (data->motion.state != state) {
+        data->motion.state = state;
+        gpio_set_level(data->gpio_open, state == RS_STATE_OPENING);
+        gpio_set_level(data->gpio_close, state == RS_STATE_CLOSING);
+    }
+    // keep CPU clock steady and esp_timer accurate while moving
+    if (!data->pm_locked) {
+        data->pm_locked = true;
+        device_pm_lock_acquire(data->pm_lock);
+    }
+    supla_rs_channel_timer_arm(data, MIN(delay_us + run_us, RS_REPORT_INTERVAL * 1000LL));
+    supla_rs_channel_journal(ch);
+    supla_rs_channel_report(ch);
+}
+
+static void supla_rs_channel_move_to(supla_channel_t *ch, int8_t target, int8_t tilt)
+{
+    struct rs_channel_data *data = supla_channel_get_data(ch);
+
+    if (target > 100 || tilt > 100 || (target < 0 && tilt < 0))
+        return;
+
+    data->motion.target_pos = target;
+    data->motion.target_tilt = tilt;
+    supla_rs_channel_move(ch);
+}
+
 static int supla_rs_set(supla_channel_t *ch, TSD_SuplaChannelNewValue *new_value)
 {
-    char task = new_value->value[0];
-    char tilt = new_value->value[1];
+    char    task = new_value->value[0];
+    char    tilt = new_value->value[1];
+    int64_t start_us = esp_timer_get_time();
 
     uint32_t open = ((new_value->DurationMS >> 0) & 0xFFFF) * 100;
     uint32_t close = ((new_value->DurationMS >> 16) & 0xFFFF) * 100;
@@ -222,107 +484,48 @@ static int supla_rs_set(supla_channel_t *ch, TSD_SuplaChannelNewValue *new_value
         supla_rs_channel_step_by_step(ch);
         break;
     default:
+        // 10-110: position or tilt 0-100%, other values: not set
         if (task >= 10 && task <= 110)
-            supla_rs_channel_set_target_position(ch, task - 10);
+            supla_rs_channel_set_target(ch, task - 10,
+                                        (tilt >= 10 && tilt <= 110) ? tilt - 10 : -1);
+        else if (tilt >= 10 && tilt <= 110)
+            supla_rs_channel_set_target_tilt(ch, tilt - 10);
         break;
     }
+    device_metrics_set_value(ch, start_us);
     return SUPLA_RESULT_TRUE;
 }
 
-static int supla_rs_tick(supla_channel_t *ch)
+static int supla_rs_timer_handler(supla_channel_t *ch)
 {
     struct rs_channel_data *data = supla_channel_get_data(ch);
-    const int               ch_num = supla_channel_get_assigned_number(ch);
-    int                     base_func, opening_time, closing_time; // tilting_time;
-    float                   diff;
-    int8_t                  position;
-    TickType_t              ticks = xTaskGetTickCount();
+    const int64_t           now = esp_timer_get_time();
 
     CHANNEL_SEMAPHORE_TAKE(data->mutex);
-    base_func = supla_rs_channel_get_base_function(ch);
-    opening_time = supla_rs_channel_get_opening_time(ch);
-    closing_time = supla_rs_channel_get_closing_time(ch);
-    //tilting_time = supla_rs_channel_get_tilting_time(ch); TODO
-    position = data->real_pos;
-
-    if (position == data->target_pos) {
-        data->state = RS_STATE_IDLE;
-    } else if (position > data->target_pos) {
-        data->state = RS_STATE_OPENING;
-    } else if (position < data->target_pos) {
-        data->state = RS_STATE_CLOSING;
-    }
-
-    switch (data->state) {
-    case RS_STATE_IDLE:
-    default:
-        gpio_set_level(data->gpio_open, 0);
-        gpio_set_level(data->gpio_close, 0);
-        break;
-    case RS_STATE_OPENING:
-        diff = opening_time ? (100.0 * RS_TIMER_INTERVAL / opening_time) : 0;
-        data->real_pos = (data->real_pos > 0) ? (data->real_pos - diff) : 0;
-        if (diff && data->real_pos > data->target_pos) {
-            gpio_set_level(data->gpio_open, 1);
-            gpio_set_level(data->gpio_close, 0);
+    if (data->motion.state != RS_STATE_IDLE) {
+        if (data->deadline_us - now > RS_TIMER_SLACK_US) {
+            if (now - data->journal_at_us >= RS_JOURNAL_INTERVAL * 1000LL)
+                supla_rs_channel_journal(ch);
+            supla_rs_channel_report(ch);
+            supla_rs_channel_timer_arm(data,
+                                       MIN(data->deadline_us - now, RS_REPORT_INTERVAL * 1000LL));
         } else {
-            supla_rs_channel_internal_stop(ch);
+            supla_rs_channel_internal_stop(ch, true);
+            supla_rs_channel_move(ch); // next step of calibration or tilt, if any
         }
-        break;
-    case RS_STATE_CLOSING:
-        diff = closing_time ? (100.0 * RS_TIMER_INTERVAL / closing_time) : 0;
-        data->real_pos = (data->real_pos < 100) ? (data->real_pos + diff) : 100;
-        if (diff && data->real_pos < data->target_pos) {
-            gpio_set_level(data->gpio_open, 0);
-            gpio_set_level(data->gpio_close, 1);
-        } else {
-            supla_rs_channel_internal_stop(ch);
-        }
-        break;
-    }
-
-    if (ticks - data->report_tick > pdMS_TO_TICKS(RS_REPORT_INTERVAL)) {
-        data->report_tick = ticks;
-
-        if (data->state != RS_STATE_IDLE) {
-            supla_log(LOG_INFO, "ch[%d] rs tick: %s position=%d target=%d last state=%d", ch_num,
-                      data->state == RS_STATE_IDLE    ? "IDLE" :
-                      data->state == RS_STATE_OPENING ? "OPENING" :
-                      data->state == RS_STATE_CLOSING ? "CLOSING" :
-                                                        "??",
-                      position, data->target_pos, data->last_state);
-        }
-
-        switch (base_func) {
-        case SUPLA_CHANNELFNC_CONTROLLINGTHEROLLERSHUTTER: {
-            TDSC_RollerShutterValue rs_val = {
-                .position = (!data->calibration) ? data->real_pos : -1, // -1: calibration needed
-            };
-            if (data->calibration && data->state != RS_STATE_IDLE)
-                rs_val.flags |= RS_VALUE_FLAG_CALIBRATION_IN_PROGRESS;
-
-            supla_channel_set_roller_shutter_value(ch, &rs_val);
-        } break;
-        case SUPLA_CHANNELFNC_CONTROLLINGTHEFACADEBLIND: {
-            TDSC_FacadeBlindValue fb_val = {
-                .position = (!data->calibration) ? data->real_pos : -1, // -1: calibration needed
-                //.flags = RS_VALUE_FLAG_TILT_IS_SET                      //
-            };
-            if (data->calibration && data->state != RS_STATE_IDLE)
-                fb_val.flags |= RS_VALUE_FLAG_CALIBRATION_IN_PROGRESS;
-
-            supla_channel_set_facadeblind_value(ch, &fb_val);
-        } break;
-        default:
-            return 0;
-        }
-    }
-
-    if (ticks - data->store_tick > pdMS_TO_TICKS(RS_STORE_INTERVAL)) {
-        data->store_tick = ticks;
-        if (data->state == RS_STATE_IDLE && data->nvs_state.stored_pos != data->real_pos) {
-            data->nvs_state.stored_pos = data->real_pos;
+    } else if (data->move_pending) {
+        data->move_pending = false;
+        supla_rs_channel_move(ch);
+        if (data->motion.state == RS_STATE_IDLE && !data->move_pending && data->store_pending)
+            supla_rs_channel_timer_arm(data, RS_STORE_INTERVAL * 1000LL);
+    } else if (data->store_pending) {
+        data->store_pending = false;
+        if (data->nvs_state.stored_pos != lroundf(data->motion.real_pos) ||
+            data->nvs_state.stored_tilt != lroundf(data->motion.real_tilt)) {
+            data->nvs_state.stored_pos = lroundf(data->motion.real_pos);
+            data->nvs_state.stored_tilt = lroundf(data->motion.real_tilt);
             supla_esp_nvs_channel_state_store(ch, &data->nvs_state, sizeof(data->nvs_state));
+            device_metrics_nvs_write();
         }
     }
     CHANNEL_SEMAPHORE_GIVE(data->mutex);
@@ -331,7 +534,7 @@ static int supla_rs_tick(supla_channel_t *ch)
 
 static void rs_timer_event(void *ch)
 {
-    supla_rs_tick(ch);
+    supla_rs_timer_handler(ch);
 }
 
 static int supla_rs_config_to_srv(supla_channel_t *ch, TSDS_SetChannelConfig *config)
@@ -397,7 +600,9 @@ static int supla_rs_config_from_srv(supla_channel_t *ch, TSD_ChannelConfig *conf
                 nvs->active_func = config->Func;
                 nvs->rs_conf = *rs_conf;
                 data->calibration = true; //will need calibration
+                supla_rs_channel_journal(ch);
                 supla_esp_nvs_channel_state_store(ch, &data->nvs_state, sizeof(data->nvs_state));
+                device_metrics_nvs_write();
             }
         }
     } break;
@@ -413,7 +618,9 @@ static int supla_rs_config_from_srv(supla_channel_t *ch, TSD_ChannelConfig *conf
                 nvs->active_func = config->Func;
                 nvs->blinds_conf = *blinds_conf;
                 data->calibration = true; //will need calibration
+                supla_rs_channel_journal(ch);
                 supla_esp_nvs_channel_state_store(ch, &data->nvs_state, sizeof(data->nvs_state));
+                device_metrics_nvs_write();
             }
         }
     } break;
@@ -436,6 +643,7 @@ static int supla_rs_on_calcfg_from_srv(supla_channel_t *ch, TSD_DeviceCalCfgRequ
     switch (calcfg->Command) {
     case SUPLA_CALCFG_CMD_RECALIBRATE:
         data->calibration = true;
+        supla_rs_channel_journal(ch);
         rc = SUPLA_CALCFG_RESULT_IN_PROGRESS;
         break;
     default:
@@ -485,27 +693,33 @@ supla_channel_t *supla_rs_channel_create(const struct rs_channel_config *config)
 
     supla_channel_set_data(ch, data);
     data->mutex = xSemaphoreCreateMutex();
-    data->state = RS_STATE_IDLE;
-    data->last_state = data->state;
-    data->real_pos = -1;
-    data->target_pos = data->real_pos;
+    data->motion.state = RS_STATE_IDLE;
+    data->last_state = data->motion.state;
+    data->motion.real_pos = -1;
+    data->motion.target_pos = data->motion.real_pos;
     data->gpio_open = config->gpio_open;
     data->gpio_close = config->gpio_close;
+    data->motion.start_delay_us = config->start_delay_ms * 1000LL;
+    data->motion.run_on_us = config->run_on_ms * 1000LL;
 
     gpio_config(&gpio_conf);
     gpio_set_level(data->gpio_open, 0);
     gpio_set_level(data->gpio_close, 0);
+    device_pm_lock_create(DEVICE_PM_NO_LIGHT_SLEEP, "rs", &data->pm_lock);
     timer_args.arg = ch;
 
     esp_timer_create(&timer_args, &data->timer);
-    esp_timer_start_periodic(data->timer, RS_TIMER_INTERVAL * 1000);
     return ch;
 }
 
 int supla_rs_channel_delete(supla_channel_t *ch)
 {
     struct rs_channel_data *data = supla_channel_get_data(ch);
+    esp_timer_stop(data->timer);
     esp_timer_delete(data->timer);
+    if (data->pm_locked)
+        device_pm_lock_release(data->pm_lock);
+    device_pm_lock_delete(data->pm_lock);
     free(data);
     return supla_channel_free(ch);
 }
@@ -515,7 +729,7 @@ int supla_rs_channel_move_stop(supla_channel_t *ch)
     struct rs_channel_data *data = supla_channel_get_data(ch);
 
     CHANNEL_SEMAPHORE_TAKE(data->mutex);
-    supla_rs_channel_internal_stop(ch);
+    supla_rs_channel_internal_stop(ch, false);
     CHANNEL_SEMAPHORE_GIVE(data->mutex);
     return ESP_OK;
 }
@@ -525,8 +739,7 @@ int supla_rs_channel_move_down(supla_channel_t *ch)
     struct rs_channel_data *data = supla_channel_get_data(ch);
 
     CHANNEL_SEMAPHORE_TAKE(data->mutex);
-    data->state = RS_STATE_CLOSING;
-    data->target_pos = 100;
+    supla_rs_channel_move_to(ch, 100, -1);
     CHANNEL_SEMAPHORE_GIVE(data->mutex);
     return ESP_OK;
 }
@@ -536,8 +749,7 @@ int supla_rs_channel_move_up(supla_channel_t *ch)
     struct rs_channel_data *data = supla_channel_get_data(ch);
 
     CHANNEL_SEMAPHORE_TAKE(data->mutex);
-    data->state = RS_STATE_OPENING;
-    data->target_pos = 0;
+    supla_rs_channel_move_to(ch, 0, -1);
     CHANNEL_SEMAPHORE_GIVE(data->mutex);
     return ESP_OK;
 }
@@ -547,12 +759,10 @@ int supla_rs_channel_move_down_or_stop(supla_channel_t *ch)
     struct rs_channel_data *data = supla_channel_get_data(ch);
 
     CHANNEL_SEMAPHORE_TAKE(data->mutex);
-    if (data->state != RS_STATE_IDLE) {
-        supla_rs_channel_internal_stop(ch);
-    } else {
-        data->state = RS_STATE_CLOSING;
-        data->target_pos = 100;
-    }
+    if (data->motion.state != RS_STATE_IDLE)
+        supla_rs_channel_internal_stop(ch, false);
+    else
+        supla_rs_channel_move_to(ch, 100, -1);
     CHANNEL_SEMAPHORE_GIVE(data->mutex);
     return ESP_OK;
 }
@@ -562,12 +772,10 @@ int supla_rs_channel_move_up_or_stop(supla_channel_t *ch)
     struct rs_channel_data *data = supla_channel_get_data(ch);
 
     CHANNEL_SEMAPHORE_TAKE(data->mutex);
-    if (data->state != RS_STATE_IDLE) {
-        supla_rs_channel_internal_stop(ch);
-    } else {
-        data->state = RS_STATE_OPENING;
-        data->target_pos = 0;
-    }
+    if (data->motion.state != RS_STATE_IDLE)
+        supla_rs_channel_internal_stop(ch, false);
+    else
+        supla_rs_channel_move_to(ch, 0, -1);
     CHANNEL_SEMAPHORE_GIVE(data->mutex);
     return ESP_OK;
 }
@@ -577,31 +785,50 @@ int supla_rs_channel_step_by_step(supla_channel_t *ch)
     struct rs_channel_data *data = supla_channel_get_data(ch);
 
     CHANNEL_SEMAPHORE_TAKE(data->mutex);
-    if (data->state != RS_STATE_IDLE) {
-        supla_rs_channel_internal_stop(ch);
-    } else if (data->last_state == RS_STATE_OPENING) {
-        data->state = RS_STATE_CLOSING;
-        data->target_pos = 100;
-    } else if (data->last_state == RS_STATE_CLOSING) {
-        data->state = RS_STATE_OPENING;
-        data->target_pos = 0;
-    } else if (data->real_pos < 50) {
-        data->state = RS_STATE_CLOSING;
-        data->target_pos = 100;
-    } else {
-        data->state = RS_STATE_OPENING;
-        data->target_pos = 0;
-    }
+    if (data->motion.state != RS_STATE_IDLE)
+        supla_rs_channel_internal_stop(ch, false);
+    else if (data->last_state == RS_STATE_OPENING)
+        supla_rs_channel_move_to(ch, 100, -1);
+    else if (data->last_state == RS_STATE_CLOSING)
+        supla_rs_channel_move_to(ch, 0, -1);
+    else if (data->motion.real_pos < 50)
+        supla_rs_channel_move_to(ch, 100, -1);
+    else
+        supla_rs_channel_move_to(ch, 0, -1);
     CHANNEL_SEMAPHORE_GIVE(data->mutex);
     return ESP_OK;
 }
 
 int supla_rs_channel_set_target_position(supla_channel_t *ch, int8_t target)
+{
+    return supla_rs_channel_set_target(ch, target, -1);
+}
+
+int supla_rs_channel_set_target_tilt(supla_channel_t *ch, int8_t tilt)
+{
+    return supla_rs_channel_set_target(ch, -1, tilt);
+}
+
+int supla_rs_channel_set_target(supla_channel_t *ch, int8_t target, int8_t tilt)
+{
+    struct rs_channel_data *data = supla_channel_get_data(ch);
+
+    CHANNEL_SEMAPHORE_TAKE(data->mutex);
+    supla_rs_channel_move_to(ch, target, tilt);
+    CHANNEL_SEMAPHORE_GIVE(data->mutex);
+    return ESP_OK;
+}
+
+int supla_rs_channel_set_motor_timing(supla_channel_t *ch, int start_delay_ms, int run_on_ms)
 {
     struct rs_channel_data *data = supla_channel_get_data(ch);
 
+    if (start_delay_ms < 0 || run_on_ms < 0)
+        return ESP_ERR_INVALID_ARG;
+
     CHANNEL_SEMAPHORE_TAKE(data->mutex);
-    data->target_pos = target;
+    data->motion.start_delay_us = start_delay_ms * 1000LL;
+    data->motion.run_on_us = run_on_ms * 1000LL;
     CHANNEL_SEMAPHORE_GIVE(data->mutex);
     return ESP_OK;
 }
@@ -0,0 +1,272 @@
+/*
+ * Copyright (c) 2025 <qb4.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "rs-journal.h"
+#include <inttypes.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/param.h>
+#include <esp_log.h>
+#include <esp_partition.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <device.h>
+
+#define JOURNAL_SECTOR_SIZE 4096
+#define JOURNAL_MAGIC 0x314a5352 // "RSJ1"
+#define JOURNAL_CHANNELS_MAX 8
+#define JOURNAL_RESERVE 128 // sector is changed on stop when fewer records are free
+#define JOURNAL_READ_RECS 16
+
+struct journal_sector_hdr {
+    uint32_t magic;
+    uint32_t seq; // newer sector has higher seq
+};
+
+struct journal_rec {
+    uint8_t ch; // channel number
+    uint8_t event;
+    int8_t  pos;
+    int8_t  tilt;
+    uint8_t reserved[3];
+    uint8_t crc;
+};
+
+#define JOURNAL_SECTOR_RECS \
+    ((JOURNAL_SECTOR_SIZE - sizeof(struct journal_sector_hdr)) / sizeof(struct journal_rec))
+
+static const char *TAG = "RS-JOURNAL";
+
+static const esp_partition_t *part;
+static SemaphoreHandle_t      lock;
+static struct journal_rec     last[JOURNAL_CHANNELS_MAX]; // newest record of each channel
+static size_t                 sectors;
+static size_t                 sector; // sector written now
+static uint32_t               sector_seq;
+static size_t                 slot; // next free record in sector
+
+static uint8_t journal_crc8(const void *data, size_t len)
+{
+    const uint8_t *p = data;
+    uint8_t        crc = 0xff;
+
+    while (len--) {
+        crc ^= *p++;
+        for (int i = 0; i < 8; i++)
+            crc = (crc & 0x80) ? (crc << 1) ^ 0x31 : crc << 1;
+    }
+    return crc;
+}
+
+static bool journal_rec_erased(const struct journal_rec *rec)
+{
+    const uint8_t *p = (const uint8_t *)rec;
+
+    for (int i = 0; i < sizeof(*rec); i++) {
+        if (p[i] != 0xff)
+            return false;
+    }
+    return true;
+}
+
+static struct journal_rec *journal_last(int ch_num)
+{
+    struct journal_rec *free_rec = NULL;
+
+    for (int i = 0; i < JOURNAL_CHANNELS_MAX; i++) {
+        if (last[i].ch == ch_num)
+            return &last[i];
+        if (!free_rec && last[i].ch == 0xff)
+            free_rec = &last[i];
+    }
+    return free_rec;
+}
+
+static size_t journal_offset(size_t sec, size_t rec_slot)
+{
+    return sec * JOURNAL_SECTOR_SIZE + sizeof(struct journal_sector_hdr) +
+           rec_slot * sizeof(struct journal_rec);
+}
+
+static esp_err_t journal_append(const struct journal_rec *rec)
+{
+    esp_err_t rc;
+
+    rc = esp_partition_write(part, journal_offset(sector, slot), rec, sizeof(*rec));
+    slot++; // failed write may leave slot half programmed, skip it anyway
+    device_metrics_journal_write();
+    return rc;
+}
+
+static esp_err_t journal_next_sector(void)
+{
+    const struct journal_sector_hdr hdr = { .magic = JOURNAL_MAGIC, .seq = sector_seq + 1 };
+    const size_t                    next = (sector + 1) % sectors;
+    esp_err_t                       rc;
+
+    rc = esp_partition_erase_range(part, next * JOURNAL_SECTOR_SIZE, JOURNAL_SECTOR_SIZE);
+    device_metrics_journal_erase();
+    if (rc == ESP_OK)
+        rc = esp_partition_write(part, next * JOURNAL_SECTOR_SIZE, &hdr, sizeof(hdr));
+    if (rc != ESP_OK) {
+        ESP_LOGE(TAG, "sector %d: %s", (int)next, esp_err_to_name(rc));
+        return rc;
+    }
+
+    sector = next;
+    sector_seq = hdr.seq;
+    slot = 0;
+    // newest state of each channel is carried over, older sector is erased next
+    for (int i = 0; i < JOURNAL_CHANNELS_MAX && rc == ESP_OK; i++) {
+        if (last[i].ch != 0xff)
+            rc = journal_append(&last[i]);
+    }
+    return rc;
+}
+
+// returns slot after last record written in sector
+static size_t journal_replay_sector(size_t sec)
+{
+    struct journal_rec recs[JOURNAL_READ_RECS];
+    size_t             end = 0;
+    size_t             num;
+
+    for (size_t n = 0; n < JOURNAL_SECTOR_RECS; n += num) {
+        num = MIN(JOURNAL_READ_RECS, JOURNAL_SECTOR_RECS - n);
+        if (esp_partition_read(part, journal_offset(sec, n), recs, num * sizeof(recs[0])) != ESP_OK)
+            return JOURNAL_SECTOR_RECS;
+
+        for (int i = 0; i < num; i++) {
+            struct journal_rec *rec = &recs[i];
+            struct journal_rec *ch_rec;
+
+            if (journal_rec_erased(rec))
+                continue;
+            end = n + i + 1;
+            // torn writes fail crc
+            if (rec->ch == 0xff || rec->crc != journal_crc8(rec, offsetof(struct journal_rec, crc)))
+                continue;
+            ch_rec = journal_last(rec->ch);
+            if (ch_rec)
+                *ch_rec = *rec;
+        }
+    }
+    return end;
+}
+
+// sectors are replayed from oldest to newest, newest one is continued
+static esp_err_t journal_replay(void)
+{
+    struct journal_sector_hdr hdr;
+    uint32_t                  next_seq = 0;
+    int                       next;
+
+    sector_seq = 0;
+    do {
+        next = -1;
+        for (int i = 0; i < sectors; i++) {
+            if (esp_partition_read(part, i * JOURNAL_SECTOR_SIZE, &hdr, sizeof(hdr)) != ESP_OK ||
+                hdr.magic != JOURNAL_MAGIC || hdr.seq <= sector_seq)
+                continue;
+            if (next < 0 || hdr.seq < next_seq) {
+                next = i;
+                next_seq = hdr.seq;
+            }
+        }
+        if (next >= 0) {
+            sector = next;
+            sector_seq = next_seq;
+            slot = journal_replay_sector(sector);
+        }
+    } while (next >= 0);
+
+    if (!sector_seq) {
+        ESP_LOGI(TAG, "empty, starting new");
+        sector = sectors - 1;
+        return journal_next_sector();
+    }
+    ESP_LOGI(TAG, "sector %d seq %" PRIu32 " slot %d", (int)sector, sector_seq, (int)slot);
+    return ESP_OK;
+}
+
+esp_err_t rs_journal_init(void)
+{
+    esp_err_t rc;
+
+    // channels are initialized one by one, first of them replays journal
+    if (lock)
+        return part ? ESP_OK : ESP_ERR_NOT_FOUND;
+
+    lock = xSemaphoreCreateMutex();
+    if (!lock)
+        return ESP_ERR_NO_MEM;
+
+    memset(last, 0xff, sizeof(last));
+    part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                    RS_JOURNAL_PARTITION);
+    if (!part) {
+        ESP_LOGW(TAG, "no %s partition, position kept in NVS", RS_JOURNAL_PARTITION);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    sectors = part->size / JOURNAL_SECTOR_SIZE;
+    rc = (sectors >= 2) ? journal_replay() : ESP_ERR_INVALID_SIZE;
+    if (rc != ESP_OK) {
+        ESP_LOGE(TAG, "init failed: %s", esp_err_to_name(rc));
+        part = NULL;
+        return ESP_ERR_NOT_FOUND;
+    }
+    return ESP_OK;
+}
+
+esp_err_t rs_journal_restore(int ch_num, int8_t *pos, int8_t *tilt, bool *moving)
+{
+    struct journal_rec *rec;
+    esp_err_t           rc = ESP_ERR_NOT_FOUND;
+
+    if (!part)
+        return ESP_ERR_INVALID_STATE;
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    rec = journal_last(ch_num);
+    if (rec && rec->ch == ch_num) {
+        *pos = rec->pos;
+        *tilt = rec->tilt;
+        *moving = (rec->event == RS_JOURNAL_MOVE);
+        rc = ESP_OK;
+    }
+    xSemaphoreGive(lock);
+    return rc;
+}
+
+esp_err_t rs_journal_write(int ch_num, enum rs_journal_event event, int8_t pos, int8_t tilt)
+{
+    struct journal_rec  rec = { .ch = ch_num, .event = event, .pos = pos, .tilt = tilt };
+    struct journal_rec *ch_rec;
+    esp_err_t           rc = ESP_OK;
+
+    if (!part)
+        return ESP_ERR_INVALID_STATE;
+    if (ch_num < 0 || ch_num >= 0xff)
+        return ESP_ERR_INVALID_ARG;
+
+    rec.crc = journal_crc8(&rec, offsetof(struct journal_rec, crc));
+    xSemaphoreTake(lock, portMAX_DELAY);
+    ch_rec = journal_last(ch_num);
+    if (!ch_rec) {
+        rc = ESP_ERR_NO_MEM;
+    } else if (memcmp(ch_rec, &rec, sizeof(rec)) != 0) {
+        *ch_rec = rec;
+        // sector is changed while motor stands, moves rarely wait for erase
+        if (slot >= JOURNAL_SECTOR_RECS ||
+            (event == RS_JOURNAL_STOP && JOURNAL_SECTOR_RECS - slot < JOURNAL_RESERVE))
+            rc = journal_next_sector();
+        else
+            rc = journal_append(&rec);
+    }
+    xSemaphoreGive(lock);
+    return rc;
+}
@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2025 <qb4.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#ifndef _RS_JOURNAL_H_
+#define _RS_JOURNAL_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <esp_err.h>
+
+/*
+ * Append-only roller shutter position journal kept in "rs_journal" data
+ * partition (two or more flash sectors used as ring). Records are 8 bytes,
+ * a sector is erased only when ring wraps, so frequent position updates do
+ * not wear NVS out.
+ */
+
+#define RS_JOURNAL_PARTITION "rs_journal"
+#define RS_JOURNAL_POS_UNKNOWN -1
+
+enum rs_journal_event {
+    RS_JOURNAL_STOP = 1, // motor stopped at pos
+    RS_JOURNAL_MOVE = 2, // motor moving, pos reached at least
+};
+
+/**
+ * @brief Find journal partition and replay it, done once for all channels
+ *
+ * @return ESP_ERR_NOT_FOUND when partition table has no journal partition
+ */
+esp_err_t rs_journal_init(void);
+
+/**
+ * @brief Last state of channel recorded in journal
+ *
+ * @param moving set when power was lost during move, pos is last checkpoint then
+ * @return ESP_ERR_NOT_FOUND when nothing was recorded for channel
+ */
+esp_err_t rs_journal_restore(int ch_num, int8_t *pos, int8_t *tilt, bool *moving);
+
+esp_err_t rs_journal_write(int ch_num, enum rs_journal_event event, int8_t pos, int8_t tilt);
+
+#endif /* _RS_JOURNAL_H_ */
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2025 <qb4.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "rs-motion.h"
+#include <math.h>
+
+#define RS_TOLERANCE 0.5f //% of position or tilt treated as reached
+
+static float rs_motion_clamp(float val)
+{
+    return val < 0 ? 0 : val > 100 ? 100 : val;
+}
+
+/*
+ * Start delay is skipped and run-on is added once outputs are off.
+ */
+int64_t rs_motion_run_time(const struct rs_motion *m, int64_t now, bool stopped)
+{
+    int64_t run_us = now - m->move_start_us - m->move_delay_us;
+
+    if (run_us <= 0)
+        return 0;
+    return stopped ? run_us + m->run_on_us : run_us;
+}
+
+/*
+ * Position and tilt are not tracked while moving, they are derived from motor
+ * run time of current move. Slats turn first, position changes after they are
+ * fully turned in direction of move.
+ */
+void rs_motion_position(const struct rs_motion *m, int64_t run_us, float *pos, float *tilt)
+{
+    int64_t elapsed = run_us;
+    int64_t tilt_us;
+    float   tilt_end;
+
+    *pos = rs_motion_clamp(m->real_pos);
+    *tilt = rs_motion_clamp(m->real_tilt);
+    if (m->state == RS_STATE_IDLE)
+        return;
+
+    if (m->tilt_full_us > 0) {
+        tilt_end = (m->state == RS_STATE_CLOSING) ? 100 : 0;
+        tilt_us = fabsf(tilt_end - *tilt) * m->tilt_full_us / 100;
+        if (elapsed < tilt_us) {
+            *tilt += m->state * 100.0f * elapsed / m->tilt_full_us;
+            elapsed = 0;
+        } else {
+            *tilt = tilt_end;
+            elapsed -= tilt_us;
+        }
+    }
+    if (m->move_full_us > 0)
+        *pos += m->state * 100.0f * elapsed / m->move_full_us;
+
+    *pos = rs_motion_clamp(*pos);
+    *tilt = rs_motion_clamp(*tilt);
+}
+
+/*
+ * Position is reached first with slats turned in direction of move, then
+ * slats are turned back.
+ */
+int64_t rs_motion_plan(const struct rs_motion *m, const struct rs_motion_times *times, float pos,
+                       float tilt, int64_t min_us, enum rs_state *state)
+{
+    int64_t run_us = 0;
+    int     full_ms;
+
+    if (m->target_pos >= 0 && fabsf(m->target_pos - pos) >= RS_TOLERANCE) {
+        *state = (m->target_pos > pos) ? RS_STATE_CLOSING : RS_STATE_OPENING;
+        full_ms = (*state == RS_STATE_CLOSING) ? times->closing_ms : times->opening_ms;
+        run_us = fabsf(m->target_pos - pos) * full_ms * 10;
+        run_us += fabsf((*state == RS_STATE_CLOSING ? 100 : 0) - tilt) * times->tilting_ms * 10;
+    }
+    if (run_us <= min_us && m->target_tilt >= 0 && fabsf(m->target_tilt - tilt) >= RS_TOLERANCE) {
+        // tilt only, position does not change while slats are turning
+        *state = (m->target_tilt > tilt) ? RS_STATE_CLOSING : RS_STATE_OPENING;
+        run_us = fabsf(m->target_tilt - tilt) * times->tilting_ms * 10;
+    }
+    return (run_us > min_us) ? run_us : 0;
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2025 <qb4.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#ifndef _RS_MOTION_H_
+#define _RS_MOTION_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Roller shutter motion model: position and tilt derived from motor run time.
+ * Plain C without ESP-IDF or FreeRTOS dependencies, so timing of moves may be
+ * checked on host against virtual clock.
+ */
+
+enum rs_state { RS_STATE_OPENING = -1, RS_STATE_IDLE = 0, RS_STATE_CLOSING = 1 };
+
+struct rs_motion {
+    enum rs_state state;
+    float         real_pos;       // 0 - opened; 100 - closed, at move start when moving
+    float         real_tilt;      // 0 - opened; 100 - closed, at move start when moving
+    int8_t        target_pos;     // 0 - opened; 100 - closed; -1 - keep
+    int8_t        target_tilt;    // 0 - opened; 100 - closed; -1 - any
+    int64_t       move_start_us;  // time when current move started
+    int64_t       move_delay_us;  // motor start delay of current move
+    int64_t       move_full_us;   // full travel time in current direction
+    int64_t       tilt_full_us;   // full tilting time, 0 when there are no slats
+    int64_t       start_delay_us; // motor starts this long after output is on
+    int64_t       run_on_us;      // motor stops this long after output is off
+};
+
+struct rs_motion_times {
+    int opening_ms;
+    int closing_ms;
+    int tilting_ms; // 0 when there are no slats
+};
+
+/**
+ * @brief Time motor was really moving since move start
+ *
+ * @param stopped outputs are off, motor run-on is added
+ */
+int64_t rs_motion_run_time(const struct rs_motion *m, int64_t now, bool stopped);
+
+/**
+ * @brief Position and tilt after motor was running run_us in current move
+ *
+ */
+void rs_motion_position(const struct rs_motion *m, int64_t run_us, float *pos, float *tilt);
+
+/**
+ * @brief Motor run time needed to reach target from pos and tilt
+ *
+ * @param min_us moves not longer than this are not made
+ * @param state direction of move
+ * @return run time in us, 0 when target is reached
+ */
+int64_t rs_motion_plan(const struct rs_motion *m, const struct rs_motion_times *times, float pos,
+                       float tilt, int64_t min_us, enum rs_state *state);
+
+#endif /* _RS_MOTION_H_ */
@@ -12,6 +12,7 @@
 #include <freertos/semphr.h>
 #include <esp_log.h>
 #include <esp_timer.h>
+#include <device.h>
 
 #define DP_MP46_MANUAL_CTRL 1
 #define DP_MP46_PERCENT_CTRL 2
@@ -67,6 +68,7 @@ static void mcu_event_handler(void *event_handler_arg, esp_event_base_t event_ba
             TDSC_RollerShutterValue rs_val = {};
             rs_val.position = 100 - dp->data.value;
             supla_channel_set_roller_shutter_value(ch, &rs_val);
+            device_notify_update();
         } break;
         case DP_MP46_MOTOR_DIRECTION: {
         } break;
@@ -84,7 +86,9 @@ static void mcu_event_handler(void *event_handler_arg, esp_event_base_t event_ba
 
 static int rs_channel_set(supla_channel_t *ch, TSD_SuplaChannelNewValue *new_value)
 {
-    char task = new_value->value[0];
+    char    task = new_value->value[0];
+    int64_t start_us = esp_timer_get_time();
+
     switch (task) {
     case 0: // STOP
         supla_mp46_rs_channel_manual_ctrl(ch, MP46_RS_MANUAL_STOP);
@@ -109,6 +113,7 @@ static int rs_channel_set(supla_channel_t *ch, TSD_SuplaChannelNewValue *new_val
             supla_mp46_rs_channel_set_target_position(ch, task - 10);
         break;
     }
+    device_metrics_set_value(ch, start_us);
     return SUPLA_RESULT_TRUE;
 }
 
@@ -7,11 +7,15 @@
 #include "include/dht-sensor.h"
 #include <stdlib.h>
 #include <esp_timer.h>
+#include <device.h>
 
 struct dht_channel_data {
     dht_sensor_type_t  sensor_type;
     gpio_num_t         gpio;
     esp_timer_handle_t timer;
+    uint32_t           poll_interval;
+    bool               oneshot;
+    int                sleep_client;
 };
 
 static void dht_poll(void *arg)
@@ -25,7 +29,15 @@ static void dht_poll(void *arg)
     rc = dht_read_float_data(dht_data->sensor_type, dht_data->gpio, &humid, &temp);
     if (rc == ESP_OK) {
         supla_channel_set_humidtemp_value(ch, humid, temp);
+        device_notify_update();
+    } else {
+        device_publish(DEVICE_EVENT_FAULT, ch, rc);
     }
+    if (dht_data->oneshot)
+        device_sleep_set_deadline(dht_data->sleep_client, 0); // no more reads
+    else
+        device_sleep_set_deadline(dht_data->sleep_client,
+                                  esp_timer_get_time() + dht_data->poll_interval * 1000LL);
 }
 
 supla_channel_t *supla_channel_dht_create(const struct dht_channel_config *config)
@@ -58,8 +70,20 @@ supla_channel_t *supla_channel_dht_create(const struct dht_channel_config *confi
     dht_data->sensor_type = config->sensor_type;
     dht_data->gpio = config->gpio;
     poll_interval = config->poll_interval_ms ? config->poll_interval_ms : 10000;
+    dht_data->poll_interval = poll_interval;
+    dht_data->oneshot = config->oneshot;
+    dht_data->sleep_client = -1;
+    device_sleep_register("dht", &dht_data->sleep_client);
 
     supla_channel_set_data(ch, dht_data);
+    if (dht_data->oneshot) {
+        dht_data->timer = NULL;
+        dht_poll(ch);
+        return ch;
+    }
+
+    device_sleep_set_deadline(dht_data->sleep_client,
+                              esp_timer_get_time() + poll_interval * 1000LL);
     timer_args.arg = ch;
     ESP_ERROR_CHECK(esp_timer_create(&timer_args, &dht_data->timer));
     ESP_ERROR_CHECK(esp_timer_start_periodic(dht_data->timer, poll_interval * 1000));
@@ -17,6 +17,7 @@ struct dht_channel_config {
     dht_sensor_type_t sensor_type;      /**< DHT sensor model (for example DHT11 or DHT22). */
     gpio_num_t        gpio;             /**< GPIO connected to DHT data pin. */
     uint32_t          poll_interval_ms; /**< Polling interval in milliseconds; 0 uses default. */
+    bool              oneshot;          /**< Read sensor once on create instead of polling. */
 };
 
 /**
@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2025 <qb4.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "captive.h"
+#include "wifi.h"
+#include <stdio.h>
+#include <string.h>
+#include <esp_log.h>
+#include <lwip/sockets.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <device.h>
+
+#define DNS_PORT 53
+#define DNS_MSG_MAX 512
+#define DNS_HEADER_SIZE 12
+#define DNS_ANSWER_SIZE 16
+#define DNS_TYPE_A 1
+#define DNS_CLASS_IN 1
+#define DNS_TTL 60
+
+static const char *TAG = "CAPTIVE";
+
+static const char *probe_uris[] = {
+    "/generate_204", // Android
+    "/gen_204",
+    "/hotspot-detect.html", // Apple
+    "/library/test/success.html",
+    "/connecttest.txt", // Windows
+    "/ncsi.txt",
+    "/redirect",
+    "/canonical.html", // Firefox
+    "/success.txt",
+};
+
+static TaskHandle_t dns_task;
+static uint32_t     ap_ip;
+
+/*
+ * Turns query in msg into reply, answer is appended after question section.
+ * Returns reply length, 0 when message is not a query to answer.
+ */
+static size_t captive_dns_reply(uint8_t *msg, size_t len, size_t size, uint32_t ip)
+{
+    size_t   pos = DNS_HEADER_SIZE;
+    uint16_t qtype, qclass;
+    bool     answer;
+
+    // standard query with one question only
+    if (len < DNS_HEADER_SIZE || msg[2] & 0xf8 || msg[4] != 0 || msg[5] != 1)
+        return 0;
+
+    while (pos < len && msg[pos]) {
+        if (msg[pos] & 0xc0) // no compression in question
+            return 0;
+        pos += msg[pos] + 1;
+    }
+    pos += 5; // root label, type, class
+    if (pos > len)
+        return 0;
+
+    qtype = msg[pos - 4] << 8 | msg[pos - 3];
+    qclass = msg[pos - 2] << 8 | msg[pos - 1];
+    answer = qtype == DNS_TYPE_A && qclass == DNS_CLASS_IN;
+    if (answer && pos + DNS_ANSWER_SIZE > size)
+        return 0;
+
+    msg[2] = 0x84 | (msg[2] & 0x01); // response, authoritative, keep recursion desired
+    msg[3] = 0x80;                   // recursion available, no error
+    msg[6] = 0;
+    msg[7] = answer;
+    memset(msg + 8, 0, 4); // additional records like EDNS are dropped
+    if (!answer)
+        return pos; // empty answer makes clients fall back to A query
+
+    msg[pos++] = 0xc0; // name points to question
+    msg[pos++] = DNS_HEADER_SIZE;
+    msg[pos++] = 0;
+    msg[pos++] = DNS_TYPE_A;
+    msg[pos++] = 0;
+    msg[pos++] = DNS_CLASS_IN;
+    msg[pos++] = DNS_TTL >> 24;
+    msg[pos++] = DNS_TTL >> 16 & 0xff;
+    msg[pos++] = DNS_TTL >> 8 & 0xff;
+    msg[pos++] = DNS_TTL & 0xff;
+    msg[pos++] = 0;
+    msg[pos++] = 4;
+    memcpy(msg + pos, &ip, 4); // already in network byte order
+    return pos + 4;
+}
+
+static void captive_dns_task(void *arg)
+{
+    static uint8_t     msg[DNS_MSG_MAX];
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(DNS_PORT),
+        .sin_addr.s_addr = htonl(INADDR_ANY),
+    };
+    struct sockaddr_in from;
+    socklen_t          from_len;
+    struct timeval     tv = { .tv_sec = 1 };
+    int                sock, len;
+
+    sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock < 0) {
+        ESP_LOGE(TAG, "socket failed");
+        goto end;
+    }
+    // wake up periodically to notice config mode exit
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        ESP_LOGE(TAG, "bind failed");
+        goto end;
+    }
+
+    ESP_LOGI(TAG, "DNS responder started");
+    while (device_get_event_bits() & DEVICE_CONFIG_EVENT_BIT) {
+        from_len = sizeof(from);
+        len = recvfrom(sock, msg, sizeof(msg), 0, (struct sockaddr *)&from, &from_len);
+        if (len <= 0)
+            continue;
+        len = captive_dns_reply(msg, len, sizeof(msg), ap_ip);
+        if (len)
+            sendto(sock, msg, len, 0, (struct sockaddr *)&from, from_len);
+    }
+    ESP_LOGI(TAG, "DNS responder stopped");
+
+end:
+    if (sock >= 0)
+        closesocket(sock);
+    dns_task = NULL;
+    vTaskDelete(NULL);
+}
+
+esp_err_t captive_dns_start(void)
+{
+    struct wifi_ip_info ip_info;
+    esp_err_t           rc;
+
+    if (dns_task)
+        return ESP_OK;
+
+    rc = wifi_get_ap_ip_info(&ip_info);
+    if (rc != ESP_OK)
+        return rc;
+
+    ap_ip = ip_info.ip;
+    if (xTaskCreate(captive_dns_task, "dns", 3072, NULL, tskIDLE_PRIORITY + 1, &dns_task) !=
+        pdPASS)
+        return ESP_ERR_NO_MEM;
+    return ESP_OK;
+}
+
+static esp_err_t captive_probe_handler(httpd_req_t *req)
+{
+    struct wifi_ip_info ip_info = {};
+    char                location[32];
+
+    wifi_get_ap_ip_info(&ip_info);
+    snprintf(location, sizeof(location), "http://%u.%u.%u.%u/", (unsigned)(ip_info.ip & 0xff),
+             (unsigned)(ip_info.ip >> 8 & 0xff), (unsigned)(ip_info.ip >> 16 & 0xff),
+             (unsigned)(ip_info.ip >> 24));
+
+    httpd_resp_set_status(req, "302 Found");
+    httpd_resp_set_hdr(req, "Location", location);
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    return httpd_resp_send(req, NULL, 0);
+}
+
+esp_err_t captive_httpd_register(httpd_handle_t server)
+{
+    httpd_uri_t uri = { .method = HTTP_GET, .handler = captive_probe_handler };
+    esp_err_t   rc;
+
+    for (int i = 0; i < sizeof(probe_uris) / sizeof(probe_uris[0]); i++) {
+        uri.uri = probe_uris[i];
+        rc = httpd_register_uri_handler(server, &uri);
+        if (rc != ESP_OK)
+            return rc;
+    }
+    return ESP_OK;
+}
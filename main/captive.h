@@ -0,0 +1,28 @@
+/*
+ * Copyright (c) 2025 <qb4.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#ifndef MAIN_CAPTIVE_H_
+#define MAIN_CAPTIVE_H_
+
+#include <esp_err.h>
+#include <esp_http_server.h>
+
+/**
+ * @brief Start DNS responder answering all A queries with AP address
+ *
+ * Responder stops on its own when DEVICE_CONFIG_EVENT_BIT is cleared.
+ */
+esp_err_t captive_dns_start(void);
+
+/**
+ * @brief Redirect OS connectivity probes to config page
+ *
+ * Phones and laptops open the captive portal sign-in page when probe
+ * answer is not the expected one.
+ */
+esp_err_t captive_httpd_register(httpd_handle_t server);
+
+#endif /* MAIN_CAPTIVE_H_ */
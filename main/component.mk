@@ -6,4 +6,5 @@ HTTPD_DATA_DIR = $(COMPONENT_PATH)/srv
 
 COMPONENT_EMBED_FILES := $(shell  $(COMPONENT_PATH)/compress_webdata.sh $(HTTPD_DATA_DIR))
 
-COMPONENT_EXTRA_CLEAN := $(COMPONENT_EMBED_FILES)
+COMPONENT_EXTRA_CLEAN := $(COMPONENT_EMBED_FILES) $(COMPONENT_PATH)/webdata.h \
+	$(HTTPD_DATA_DIR)/.webdata.stamp
@@ -4,8 +4,98 @@ HTTPD_DATA_DIR="srv"
 
 [ ! -z $1 ] && HTTPD_DATA_DIR=$1
 
-for file in $(find $HTTPD_DATA_DIR -regextype posix-extended -regex '.*\.(html|css|js|svg|png|jpg|jpeg|ico)'); do
-    gzip -kfq --best $file
-    echo -n "${file}.gz "
+# html pages are bundled with the css and js they reference into one gzip file, other assets
+# are gzipped as they are and referenced with ?v=<hash>; content hashes of compressed files
+# are used as ETags
+WEBDATA_HEADER="$(dirname $HTTPD_DATA_DIR)/webdata.h"
+WEBDATA_STAMP="$HTTPD_DATA_DIR/.webdata.stamp"
+WEBDATA_REGEX='.*\.(html|css|js|svg|png|jpg|jpeg|ico)'
+
+webdata_hash() {
+    sha256sum $1 | cut -c1-16
+}
+
+webdata_name() {
+    basename $1 | tr -c '[:alnum:]\n' '_'
+}
+
+# strip comments, indentation and line breaks
+minify_css() {
+    tr '\n\t' '  ' <$1 | sed -e 's#/\*\([^*]\|\*[^/]\)*\*/##g' -e 's/  */ /g' \
+        -e 's/ *\([{};,]\) */\1/g' -e 's/;}/}/g'
+    echo
+}
+
+# strip indentation, blank and comment lines; line breaks are kept for semicolon insertion
+minify_lines() {
+    sed -e 's/^[[:space:]]*//' -e 's/[[:space:]]*$//' -e '/^\/\//d' -e '/^$/d'
+}
+
+bundle_html() {
+    local dir=$(dirname $1)
+    local re_css='<link rel="stylesheet" href="([^"]+)">'
+    local re_js='<script src="([^"]+)"></script>'
+
+    while IFS= read -r line; do
+        if [[ $line =~ $re_css ]] && [ -f $dir/${BASH_REMATCH[1]} ]; then
+            echo "<style>$(minify_css $dir/${BASH_REMATCH[1]})</style>"
+        elif [[ $line =~ $re_js ]] && [ -f $dir/${BASH_REMATCH[1]} ]; then
+            echo "<script>"
+            cat $dir/${BASH_REMATCH[1]}
+            echo "</script>"
+        else
+            echo "$line"
+        fi
+    done <$1 | minify_lines
+}
+
+html_files=$(find $HTTPD_DATA_DIR -name '*.html' | sort)
+inlined=$(cat $html_files /dev/null | sed -n -E 's/.*(href|src)="([^"]+\.(css|js))".*/\2/p' | sort -u)
+assets=""
+for file in $(find $HTTPD_DATA_DIR -regextype posix-extended -regex "$WEBDATA_REGEX" ! -name '*.html' | sort); do
+    echo "$inlined" | grep -qx "$(basename $file)" || assets="$assets $file"
+done
+
+outputs=""
+for file in $html_files $assets; do
+    outputs="$outputs ${file}.gz"
+done
+
+# outputs are rewritten only when sources or this script change, so nothing is rebuilt needlessly
+stamp=$(cat $0 $html_files $(find $HTTPD_DATA_DIR -regextype posix-extended -regex "$WEBDATA_REGEX" \
+    ! -name '*.html' | sort) | sha256sum | cut -c1-64)
+uptodate=1
+for file in $outputs $WEBDATA_HEADER; do
+    [ -f $file ] || uptodate=0
+done
+[ "$(cat $WEBDATA_STAMP 2>/dev/null)" == "$stamp" ] || uptodate=0
+
+if [ $uptodate == 0 ]; then
+    HEADER_TMP=$(mktemp)
+    echo "// generated by compress_webdata.sh, do not edit" >$HEADER_TMP
+    echo "#pragma once" >>$HEADER_TMP
+
+    SED_ARGS=(-e '')
+    for file in $assets; do
+        gzip -nkfq --best $file
+        hash=$(webdata_hash ${file}.gz)
+        echo "#define WEBDATA_HASH_$(webdata_name ${file}.gz) \"$hash\"" >>$HEADER_TMP
+        # page picks up new asset after firmware update
+        name=$(basename $file)
+        SED_ARGS+=(-e "s#\(href\|src\)=\"${name//./\\.}\"#\1=\"$name?v=$hash\"#g")
+    done
+    for file in $html_files; do
+        bundle_html $file | sed "${SED_ARGS[@]}" | gzip -nq --best >${file}.gz
+        echo "#define WEBDATA_HASH_$(webdata_name ${file}.gz) \"$(webdata_hash ${file}.gz)\"" \
+            >>$HEADER_TMP
+    done
+
+    cmp -s $HEADER_TMP $WEBDATA_HEADER || cp $HEADER_TMP $WEBDATA_HEADER
+    rm -f $HEADER_TMP
+    echo $stamp >$WEBDATA_STAMP
+fi
+
+for file in $outputs; do
+    echo -n "${file} "
 done
 echo ""
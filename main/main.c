@@ -15,17 +15,29 @@
 
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
+#include <freertos/event_groups.h>
 
 #include <device.h>
 #include <board.h>
 
 #include "wifi.h"
 #include "webserver.h"
+#include "stats.h"
+#include "sysmon.h"
+#include "metrics.h"
+#include "ota.h"
+#include "ota_pull.h"
+#include "captive.h"
+#include "wifi_scan.h"
 
 static const char *TAG = "APP";
 
-static char         hostname[32];
-static supla_dev_t *supla_dev;
+#define APP_WIFI_READY_BIT BIT0
+#define APP_GOT_IP_BIT BIT1
+
+static char               hostname[32];
+static supla_dev_t       *supla_dev;
+static EventGroupHandle_t app_events;
 
 static struct supla_config supla_config = {
 #ifdef CONFIG_ESP_LIBSUPLA_USE_ESP_TLS
@@ -52,12 +64,7 @@ static void net_event_handler(void *arg, esp_event_base_t base, int32_t id, void
             //              /*Switch to 802.11 bgn mode */
             //              esp_wifi_set_protocol(ESP_IF_WIFI_STA, WIFI_PROTOCOL_11B | WIFI_PROTOCOL_11G | WIFI_PROTOCOL_11N);
             //          }
-            if (info->reason == WIFI_REASON_ASSOC_LEAVE)
-                break; // disconnected by user
-
-            /* Let the chip cool down for a while */
-            vTaskDelay(pdMS_TO_TICKS(5000));
-            esp_wifi_connect();
+            /* reconnect is scheduled by wifi module */
         } break;
         default:
             break;
@@ -67,7 +74,10 @@ static void net_event_handler(void *arg, esp_event_base_t base, int32_t id, void
         case IP_EVENT_STA_GOT_IP: {
             ip_event_got_ip_t *event = data;
             ESP_LOGI(TAG, "got ip:" IPSTR, IP2STR(&event->ip_info.ip));
-            supla_dev_start(supla_dev);
+            stats_boot_mark(BOOT_PHASE_WIFI_GOT_IP);
+            /* supla connection is started from main loop when board init is done */
+            xEventGroupSetBits(app_events, APP_GOT_IP_BIT);
+            device_notify_update();
         } break;
         default:
             break;
@@ -80,17 +90,39 @@ static void dev_event_handler(void *event_handler_arg, esp_event_base_t event_ba
 {
     switch (event_id) {
     case DEVICE_EVENT_CONFIG_INIT:
+#ifdef CONFIG_APP_OTA_PULL
+        ota_pull_config_mode(true);
+#endif
         board_on_config_mode_init();
         supla_dev_enter_config_mode(supla_dev);
         wifi_set_access_point_mode(hostname);
         webserver_start(&supla_dev, bsp);
+        captive_dns_start();
+        wifi_scan_start(); // network list ready when config page opens
         break;
     case DEVICE_EVENT_CONFIG_EXIT: {
+#ifdef CONFIG_APP_OTA_PULL
+        ota_pull_config_mode(false);
+#endif
         board_on_config_mode_exit();
         supla_dev_exit_config_mode(supla_dev);
         webserver_stop();
         wifi_set_station_mode();
+#ifdef CONFIG_APP_STATION_WEBSERVER
+        webserver_start_station();
+#endif
+    } break;
+    case DEVICE_EVENT_SLEEP_INIT: {
+        device_sleep_event_t *ev = event_data;
+
+        if (ev->mode == DEVICE_SLEEP_MODE_MODEM)
+            esp_wifi_set_ps(WIFI_PS_MAX_MODEM);
+        else if (ev->mode == DEVICE_SLEEP_MODE_DEEP)
+            stats_boot_log(); // awake time breakdown of this wake cycle
     } break;
+    case DEVICE_EVENT_SLEEP_RESUME:
+        esp_wifi_set_ps(WIFI_PS_MIN_MODEM);
+        break;
     default:
         break;
     }
@@ -99,6 +131,10 @@ static void dev_event_handler(void *event_handler_arg, esp_event_base_t event_ba
 static void supla_dev_state_change_callback(supla_dev_t *dev, supla_dev_state_t state)
 {
     supla_log(LOG_INFO, "state -> %s", supla_dev_state_str(state));
+    metrics_supla_state(state);
+#ifdef CONFIG_APP_OTA_PULL
+    ota_pull_supla_state(state);
+#endif
 
     switch (state) {
     case SUPLA_DEV_STATE_CONFIG:
@@ -109,10 +145,13 @@ static void supla_dev_state_change_callback(supla_dev_t *dev, supla_dev_state_t
     case SUPLA_DEV_STATE_INIT:
         break;
     case SUPLA_DEV_STATE_CONNECTED:
+        stats_boot_mark(BOOT_PHASE_SUPLA_CONNECTED);
         break;
     case SUPLA_DEV_STATE_REGISTERED:
+        stats_boot_mark(BOOT_PHASE_SUPLA_REGISTERED);
         break;
     case SUPLA_DEV_STATE_ONLINE:
+        stats_boot_mark(BOOT_PHASE_SUPLA_ONLINE);
         break;
     default:
         break;
@@ -135,30 +174,93 @@ static esp_err_t supla_device_init(void)
     return ESP_OK;
 }
 
+static void wifi_start(void)
+{
+    ESP_ERROR_CHECK(wifi_init(net_event_handler));
+    ESP_ERROR_CHECK(wifi_scan_init());
+    stats_boot_mark(BOOT_PHASE_WIFI_INIT);
+
+    if (supla_config.email[0] != 0)
+        wifi_set_station_mode();
+    xEventGroupSetBits(app_events, APP_WIFI_READY_BIT);
+}
+
+#ifdef CONFIG_APP_PARALLEL_INIT
+static void wifi_start_task(void *arg)
+{
+    wifi_start();
+    vTaskDelete(NULL);
+}
+#endif
+
 void app_main()
 {
-    esp_err_t err = nvs_flash_init();
+    esp_err_t err;
+
+    stats_boot_mark(BOOT_PHASE_APP_MAIN);
+    err = nvs_flash_init();
     if (err == ESP_ERR_NVS_NO_FREE_PAGES || err == ESP_ERR_NVS_NEW_VERSION_FOUND) {
         // NVS partition was truncated or version mismatch → erase and retry
         ESP_ERROR_CHECK(nvs_flash_erase());
         err = nvs_flash_init();
     }
     ESP_ERROR_CHECK(err);
+    stats_boot_mark(BOOT_PHASE_NVS_INIT);
+    ESP_ERROR_CHECK(ota_init());
+#ifdef CONFIG_APP_OTA_PULL
+    ESP_ERROR_CHECK(ota_pull_init());
+#endif
+    ESP_ERROR_CHECK(sysmon_init());
     ESP_ERROR_CHECK(board_early_init());
+    stats_boot_mark(BOOT_PHASE_BOARD_EARLY_INIT);
     ESP_ERROR_CHECK(esp_event_loop_create_default());
 
     ESP_ERROR_CHECK(device_init(dev_event_handler, NULL));
+    stats_boot_mark(BOOT_PHASE_DEVICE_INIT);
     ESP_ERROR_CHECK(supla_device_init());
+    stats_boot_mark(BOOT_PHASE_SUPLA_INIT);
+
+    app_events = xEventGroupCreate();
+#ifdef CONFIG_APP_PARALLEL_INIT
+    // radio init and association overlap with board channels setup
+    xTaskCreate(wifi_start_task, "wifi_start", 4096, NULL, tskIDLE_PRIORITY + 1, NULL);
     ESP_ERROR_CHECK(board_supla_init(supla_dev));
-    ESP_ERROR_CHECK(wifi_init(net_event_handler));
+    stats_boot_mark(BOOT_PHASE_BOARD_SUPLA_INIT);
+#else
+    ESP_ERROR_CHECK(board_supla_init(supla_dev));
+    stats_boot_mark(BOOT_PHASE_BOARD_SUPLA_INIT);
+    wifi_start();
+#endif
+    xEventGroupWaitBits(app_events, APP_WIFI_READY_BIT, pdFALSE, pdTRUE, portMAX_DELAY);
 
     if (supla_config.email[0] == 0)
         device_init_config();
+#ifdef CONFIG_APP_STATION_WEBSERVER
     else
-        wifi_set_station_mode();
+        webserver_start_station();
+#endif
+#ifdef CONFIG_APP_OTA_PULL
+    ESP_ERROR_CHECK(ota_pull_start());
+#endif
 
     while (1) {
+        const uint32_t    update_seq = device_update_seq();
+        supla_dev_state_t state;
+        int64_t           latency_us = 0;
+        esp_err_t         rc;
+
+        if (xEventGroupClearBits(app_events, APP_GOT_IP_BIT) & APP_GOT_IP_BIT)
+            supla_dev_start(supla_dev);
+
         supla_dev_iterate(supla_dev);
-        vTaskDelay(pdMS_TO_TICKS(100));
+        // values changed before iteration are sent by it when online
+        if (supla_dev_get_state(supla_dev, &state) == SUPLA_RESULT_TRUE &&
+            state == SUPLA_DEV_STATE_ONLINE)
+            device_update_sent(update_seq);
+        /* sleep until some channel value changes or max sleep time elapses */
+        rc = device_wait_update(pdMS_TO_TICKS(CONFIG_APP_SUPLA_LOOP_MAX_SLEEP_MS), &latency_us);
+        stats_loop_record(rc == ESP_OK, latency_us);
+        if (rc == ESP_ERR_TIMEOUT)
+            device_sleep_enter();
     }
 }
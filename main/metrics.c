@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2025 <qb4.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "metrics.h"
+#include "wifi.h"
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <inttypes.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+#include <esp_wifi.h>
+#include <device.h>
+
+#define METRICS_CHUNK_SIZE 512 // longest line written, lines are never split
+
+struct metrics_writer {
+    httpd_req_t *req;
+    size_t       len;
+    esp_err_t    rc;
+};
+
+static struct {
+    uint32_t connects;
+    uint32_t registrations;
+} supla_stats;
+
+static supla_dev_state_t supla_state = SUPLA_DEV_STATE_IDLE;
+
+// httpd handles one request at a time, so single buffer is enough
+static char metrics_buf[METRICS_CHUNK_SIZE];
+
+static void mw_flush(struct metrics_writer *w)
+{
+    if (w->len && w->rc == ESP_OK)
+        w->rc = httpd_resp_send_chunk(w->req, metrics_buf, w->len);
+    w->len = 0;
+}
+
+/*
+ * Whole line is appended to buffer or buffer is sent first, so no partial line
+ * goes out. Line longer than buffer fails the response.
+ */
+static void __attribute__((format(printf, 2, 3)))
+mw_printf(struct metrics_writer *w, const char *fmt, ...)
+{
+    va_list args;
+    int     len;
+
+    if (w->rc != ESP_OK)
+        return;
+
+    va_start(args, fmt);
+    len = vsnprintf(metrics_buf + w->len, sizeof(metrics_buf) - w->len, fmt, args);
+    va_end(args);
+    if (len >= 0 && len < sizeof(metrics_buf) - w->len) {
+        w->len += len;
+        return;
+    }
+
+    mw_flush(w);
+    va_start(args, fmt);
+    len = vsnprintf(metrics_buf, sizeof(metrics_buf), fmt, args);
+    va_end(args);
+    if (len < 0 || len >= sizeof(metrics_buf))
+        w->rc = ESP_ERR_INVALID_SIZE;
+    else if (w->rc == ESP_OK)
+        w->len = len;
+}
+
+static void mw_header(struct metrics_writer *w, const char *name, const char *type,
+                      const char *help)
+{
+    mw_printf(w, "# HELP %s %s\n", name, help);
+    mw_printf(w, "# TYPE %s %s\n", name, type);
+}
+
+static void mw_metric(struct metrics_writer *w, const char *name, const char *type,
+                      const char *help, uint32_t val)
+{
+    mw_header(w, name, type, help);
+    mw_printf(w, "%s %" PRIu32 "\n", name, val);
+}
+
+static void metrics_system(struct metrics_writer *w)
+{
+    mw_metric(w, "supla_uptime_seconds", "counter", "Time since boot",
+              esp_timer_get_time() / 1000000);
+    mw_metric(w, "supla_heap_free_bytes", "gauge", "Free heap", esp_get_free_heap_size());
+    mw_metric(w, "supla_heap_min_free_bytes", "gauge", "Lowest free heap since boot",
+              esp_get_minimum_free_heap_size());
+}
+
+static void metrics_wifi(struct metrics_writer *w)
+{
+    struct wifi_reconnect_stats st;
+    wifi_ap_record_t            ap_info;
+
+    wifi_get_reconnect_stats(&st);
+    mw_metric(w, "supla_wifi_disconnects_total", "counter", "Station disconnects",
+              st.disconnects);
+    mw_metric(w, "supla_wifi_reconnects_total", "counter", "Completed station reconnects",
+              st.reconnects);
+    mw_metric(w, "supla_wifi_reconnect_max_ms", "gauge", "Longest time from disconnect to IP",
+              st.max_reconnect_ms);
+    if (esp_wifi_sta_get_ap_info(&ap_info) == ESP_OK) {
+        mw_header(w, "supla_wifi_rssi_dbm", "gauge", "Signal strength");
+        mw_printf(w, "supla_wifi_rssi_dbm %d\n", ap_info.rssi);
+    }
+}
+
+static void metrics_supla(struct metrics_writer *w)
+{
+    mw_metric(w, "supla_server_online", "gauge", "Registered on SUPLA server",
+              supla_state == SUPLA_DEV_STATE_ONLINE);
+    mw_metric(w, "supla_server_connects_total", "counter", "SUPLA server connections",
+              supla_stats.connects);
+    mw_metric(w, "supla_server_registrations_total", "counter", "SUPLA server registrations",
+              supla_stats.registrations);
+}
+
+static void metrics_device(struct metrics_writer *w)
+{
+    static device_metrics_t m; // too big for httpd stack
+    device_event_stats_t    ev;
+
+    if (device_metrics_get(&m) == ESP_OK) {
+        mw_metric(w, "supla_nvs_writes_total", "counter", "Flash writes of persistent state",
+                  m.nvs_writes);
+        mw_metric(w, "supla_rs_journal_writes_total", "counter",
+                  "Roller shutter journal records", m.journal_writes);
+        mw_metric(w, "supla_rs_journal_erases_total", "counter",
+                  "Roller shutter journal sector erases", m.journal_erases);
+
+        mw_header(w, "supla_channel_set_value_total", "counter", "Commands handled by channel");
+        for (int i = 0; i < m.channels_num; i++)
+            mw_printf(w, "supla_channel_set_value_total{channel=\"%d\"} %" PRIu32 "\n",
+                      supla_channel_get_assigned_number(m.channels[i].channel),
+                      m.channels[i].set_value_count);
+
+        mw_header(w, "supla_channel_command_latency_us", "summary", "Command handler run time");
+        for (int i = 0; i < m.channels_num; i++) {
+            const int ch_num = supla_channel_get_assigned_number(m.channels[i].channel);
+
+            mw_printf(w, "supla_channel_command_latency_us_sum{channel=\"%d\"} %" PRIu32 "\n",
+                      ch_num, m.channels[i].latency_sum_us);
+            mw_printf(w, "supla_channel_command_latency_us_count{channel=\"%d\"} %" PRIu32 "\n",
+                      ch_num, m.channels[i].set_value_count);
+        }
+
+        mw_header(w, "supla_channel_command_latency_max_us", "gauge",
+                  "Longest command handler run");
+        for (int i = 0; i < m.channels_num; i++)
+            mw_printf(w, "supla_channel_command_latency_max_us{channel=\"%d\"} %" PRIu32 "\n",
+                      supla_channel_get_assigned_number(m.channels[i].channel),
+                      m.channels[i].latency_max_us);
+    }
+
+    if (device_event_get_stats(&ev) == ESP_OK) {
+        mw_header(w, "supla_device_events_dropped_total", "counter", "Events lost on full queue");
+        mw_printf(w, "supla_device_events_dropped_total{prio=\"normal\"} %" PRIu32 "\n",
+                  ev.dropped[DEVICE_EVENT_PRIO_NORMAL]);
+        mw_printf(w, "supla_device_events_dropped_total{prio=\"high\"} %" PRIu32 "\n",
+                  ev.dropped[DEVICE_EVENT_PRIO_HIGH]);
+    }
+}
+
+void metrics_supla_state(supla_dev_state_t state)
+{
+    if (state == SUPLA_DEV_STATE_CONNECTED)
+        supla_stats.connects++;
+    else if (state == SUPLA_DEV_STATE_REGISTERED)
+        supla_stats.registrations++;
+    supla_state = state;
+}
+
+esp_err_t metrics_httpd_handler(httpd_req_t *req)
+{
+    struct metrics_writer w = { .req = req, .rc = ESP_OK };
+
+    httpd_resp_set_type(req, "text/plain; version=0.0.4");
+
+    metrics_system(&w);
+    metrics_wifi(&w);
+    metrics_supla(&w);
+    metrics_device(&w);
+    mw_flush(&w);
+    if (w.rc != ESP_OK)
+        return w.rc;
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
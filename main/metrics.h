@@ -0,0 +1,25 @@
+/*
+ * Copyright (c) 2025 <qb4.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#ifndef MAIN_METRICS_H_
+#define MAIN_METRICS_H_
+
+#include <esp_http_server.h>
+#include <esp-supla.h>
+
+/**
+ * @brief Count SUPLA server connection state changes
+ *
+ */
+void metrics_supla_state(supla_dev_state_t state);
+
+/**
+ * @brief Serve runtime counters in Prometheus text format
+ *
+ */
+esp_err_t metrics_httpd_handler(httpd_req_t *req);
+
+#endif /* MAIN_METRICS_H_ */
@@ -0,0 +1,397 @@
+/*
+ * Copyright (c) 2025 <qb4.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "ota.h"
+#include "sse.h"
+#include "ota_hs.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <esp_log.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+#include <esp_ota_ops.h>
+#include <mbedtls/sha256.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <device.h>
+
+#define OTA_BUF_SIZE 4096 // one flash sector
+#define OTA_BUF_NUM 2
+#define OTA_RECV_RETRIES 5
+#define OTA_PROGRESS_INTERVAL_US (500 * 1000)
+#define OTA_RESTART_DELAY_US (1000 * 1000)
+#define OTA_SHA256_HEADER "X-Firmware-SHA256"
+
+#ifdef CONFIG_IDF_TARGET_ESP8266
+#define OTA_BEGIN_SIZE(size) (size)
+#define ota_abort esp_ota_end
+#define sha256_starts(ctx) mbedtls_sha256_starts_ret(ctx, 0)
+#define sha256_update mbedtls_sha256_update_ret
+#define sha256_finish mbedtls_sha256_finish_ret
+#else
+// sectors are erased as they are written, not all upfront
+#define OTA_BEGIN_SIZE(size) OTA_WITH_SEQUENTIAL_WRITES
+#define ota_abort esp_ota_abort
+#define sha256_starts(ctx) mbedtls_sha256_starts(ctx, 0)
+#define sha256_update mbedtls_sha256_update
+#define sha256_finish mbedtls_sha256_finish
+#endif
+
+static const char *TAG = "OTA";
+
+struct ota_chunk {
+    char  *data;
+    size_t len; // 0 stops writer
+};
+
+// first bytes are read ahead to detect compressed image
+struct ota_src {
+    ota_read_fn read;
+    void       *ctx;
+    uint8_t     head[OTA_HS_HEADER_SIZE];
+    size_t      head_len;
+    size_t      head_pos;
+};
+
+static struct {
+    esp_ota_handle_t   handle;
+    QueueHandle_t      full_q;
+    QueueHandle_t      free_q;
+    SemaphoreHandle_t  done;
+    volatile esp_err_t rc;
+} writer;
+
+static SemaphoreHandle_t       ota_mutex;
+static device_pm_lock_handle_t ota_pm_lock;
+static esp_timer_handle_t      restart_timer;
+
+static void ota_writer_task(void *arg)
+{
+    struct ota_chunk chunk;
+
+    for (;;) {
+        xQueueReceive(writer.full_q, &chunk, portMAX_DELAY);
+        if (!chunk.len)
+            break;
+        // after first error only drain buffers, receiver stops on its own
+        if (writer.rc == ESP_OK)
+            writer.rc = esp_ota_write(writer.handle, chunk.data, chunk.len);
+        xQueueSend(writer.free_q, &chunk.data, portMAX_DELAY);
+    }
+    xSemaphoreGive(writer.done);
+    vTaskDelete(NULL);
+}
+
+static void ota_writer_free_bufs(void)
+{
+    char *buf;
+
+    while (xQueueReceive(writer.free_q, &buf, 0) == pdTRUE)
+        free(buf);
+}
+
+static esp_err_t ota_writer_start(void)
+{
+    char *buf;
+
+    if (!writer.full_q) {
+        writer.full_q = xQueueCreate(OTA_BUF_NUM + 1, sizeof(struct ota_chunk));
+        writer.free_q = xQueueCreate(OTA_BUF_NUM, sizeof(char *));
+        writer.done = xSemaphoreCreateBinary();
+        if (!writer.full_q || !writer.free_q || !writer.done)
+            return ESP_ERR_NO_MEM;
+    }
+    xQueueReset(writer.full_q);
+    xQueueReset(writer.free_q);
+
+    // buffers are taken only for the update, heap is too tight to keep them
+    for (int i = 0; i < OTA_BUF_NUM; i++) {
+        buf = malloc(OTA_BUF_SIZE);
+        if (!buf) {
+            ota_writer_free_bufs();
+            return ESP_ERR_NO_MEM;
+        }
+        xQueueSend(writer.free_q, &buf, 0);
+    }
+
+    writer.rc = ESP_OK;
+    if (xTaskCreate(ota_writer_task, "ota_wr", 3072, NULL, uxTaskPriorityGet(NULL), NULL) !=
+        pdPASS) {
+        ota_writer_free_bufs();
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+// all buffers are back on free queue once writer is done
+static void ota_writer_stop(void)
+{
+    struct ota_chunk chunk = { 0 };
+
+    xQueueSend(writer.full_q, &chunk, portMAX_DELAY);
+    xSemaphoreTake(writer.done, portMAX_DELAY);
+    ota_writer_free_bufs();
+}
+
+static esp_err_t ota_fill(ota_read_fn read, void *ctx, char *buf, size_t len)
+{
+    for (size_t got = 0; got < len;) {
+        int n = read(ctx, buf + got, len - got);
+
+        if (n <= 0)
+            return ESP_FAIL;
+        got += n;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t ota_stream(ota_read_fn read, void *ctx, size_t size, ota_progress_fn progress,
+                            struct ota_result *res)
+{
+    const esp_partition_t *part = esp_ota_get_next_update_partition(NULL);
+    mbedtls_sha256_context sha;
+    struct ota_chunk       chunk;
+    int64_t                started = esp_timer_get_time();
+    int64_t                reported = started;
+    int64_t                now;
+    esp_err_t              rc;
+
+    if (!part)
+        return ESP_ERR_NOT_FOUND;
+    if (!size || size > part->size)
+        return ESP_ERR_INVALID_SIZE;
+
+    ESP_LOGI(TAG, "writing %u bytes to %s", (unsigned)size, part->label);
+    rc = esp_ota_begin(part, OTA_BEGIN_SIZE(size), &writer.handle);
+    if (rc != ESP_OK)
+        return rc;
+
+    rc = ota_writer_start();
+    if (rc != ESP_OK) {
+        ota_abort(writer.handle);
+        return rc;
+    }
+
+    mbedtls_sha256_init(&sha);
+    sha256_starts(&sha);
+    while (res->bytes < size) {
+        // blocks while both buffers are queued for flash
+        xQueueReceive(writer.free_q, &chunk.data, portMAX_DELAY);
+        chunk.len = size - res->bytes < OTA_BUF_SIZE ? size - res->bytes : OTA_BUF_SIZE;
+
+        rc = ota_fill(read, ctx, chunk.data, chunk.len);
+        if (rc == ESP_OK)
+            rc = writer.rc;
+        if (rc != ESP_OK) {
+            xQueueSend(writer.free_q, &chunk.data, 0);
+            break;
+        }
+        // hashing overlaps with flash write of previous chunk
+        sha256_update(&sha, (const unsigned char *)chunk.data, chunk.len);
+        xQueueSend(writer.full_q, &chunk, portMAX_DELAY);
+        res->bytes += chunk.len;
+
+        now = esp_timer_get_time();
+        if (progress && now - reported >= OTA_PROGRESS_INTERVAL_US) {
+            progress(res->bytes, size, res->bytes * 1000000ULL / (now - started));
+            reported = now;
+        }
+    }
+    ota_writer_stop();
+    sha256_finish(&sha, res->sha256);
+    mbedtls_sha256_free(&sha);
+
+    if (rc == ESP_OK)
+        rc = writer.rc;
+    now = esp_timer_get_time();
+    res->bytes_per_sec = now > started ? res->bytes * 1000000ULL / (now - started) : 0;
+    if (rc != ESP_OK) {
+        ota_abort(writer.handle);
+        return rc;
+    }
+    return esp_ota_end(writer.handle);
+}
+
+static esp_err_t ota_finish(const struct ota_result *res, const uint8_t *expected_sha256)
+{
+    const esp_partition_t *part = esp_ota_get_next_update_partition(NULL);
+
+    if (expected_sha256 && memcmp(expected_sha256, res->sha256, sizeof(res->sha256))) {
+        ESP_LOGE(TAG, "image hash mismatch");
+        return ESP_ERR_OTA_VALIDATE_FAILED;
+    }
+    return esp_ota_set_boot_partition(part);
+}
+
+static void ota_restart_cb(void *arg)
+{
+    esp_restart();
+}
+
+void ota_restart_later(void)
+{
+    esp_timer_create_args_t timer_args = {
+        .name = "ota_restart",
+        .dispatch_method = ESP_TIMER_TASK,
+        .callback = ota_restart_cb,
+    };
+
+    // let response reach the client first
+    if (!restart_timer)
+        esp_timer_create(&timer_args, &restart_timer);
+    esp_timer_start_once(restart_timer, OTA_RESTART_DELAY_US);
+}
+
+void ota_sha256_to_hex(const uint8_t *sha256, char *hex)
+{
+    for (int i = 0; i < 32; i++)
+        sprintf(hex + 2 * i, "%02x", sha256[i]);
+}
+
+esp_err_t ota_sha256_from_hex(const char *hex, uint8_t *sha256)
+{
+    unsigned int byte;
+
+    if (strlen(hex) != 64)
+        return ESP_ERR_INVALID_ARG;
+    for (int i = 0; i < 32; i++) {
+        if (sscanf(hex + 2 * i, "%2x", &byte) != 1)
+            return ESP_ERR_INVALID_ARG;
+        sha256[i] = byte;
+    }
+    return ESP_OK;
+}
+
+static int ota_src_read(void *ctx, char *buf, size_t len)
+{
+    struct ota_src *src = ctx;
+    size_t          n = src->head_len - src->head_pos;
+
+    if (!n)
+        return src->read(src->ctx, buf, len);
+    if (n > len)
+        n = len;
+    memcpy(buf, src->head + src->head_pos, n);
+    src->head_pos += n;
+    return n;
+}
+
+esp_err_t ota_init(void)
+{
+    ota_mutex = xSemaphoreCreateMutex();
+    if (!ota_mutex)
+        return ESP_ERR_NO_MEM;
+    return device_pm_lock_create(DEVICE_PM_CPU_FREQ_MAX, "ota", &ota_pm_lock);
+}
+
+esp_err_t ota_update(ota_read_fn read, void *ctx, size_t len, ota_progress_fn progress,
+                     const uint8_t *expected_sha256, struct ota_result *res)
+{
+    struct ota_src src = { .read = read, .ctx = ctx };
+    ota_hs_t       hs = { 0 };
+    ota_read_fn    image_read = ota_src_read;
+    void          *image_ctx = &src;
+    uint32_t       size = len;
+    uint8_t        window_sz2, lookahead_sz2;
+    esp_err_t      rc;
+
+    memset(res, 0, sizeof(*res));
+    // upload and pull share one writer
+    if (!ota_mutex || xSemaphoreTake(ota_mutex, 0) != pdTRUE)
+        return ESP_ERR_INVALID_STATE;
+    device_pm_lock_acquire(ota_pm_lock);
+
+    rc = len < sizeof(src.head) ? ESP_ERR_INVALID_SIZE :
+                                  ota_fill(read, ctx, (char *)src.head, sizeof(src.head));
+    if (rc != ESP_OK)
+        goto end;
+
+    rc = ota_hs_parse_header(src.head, &window_sz2, &lookahead_sz2, &size);
+    if (rc == ESP_ERR_NOT_FOUND) {
+        // plain image, header bytes are replayed to the writer
+        src.head_len = sizeof(src.head);
+        rc = ESP_OK;
+    } else if (rc == ESP_OK) {
+        ESP_LOGI(TAG, "compressed image %u -> %u bytes", (unsigned)len, (unsigned)size);
+        rc = ota_hs_init(&hs, window_sz2, lookahead_sz2, ota_src_read, &src);
+        image_read = ota_hs_read;
+        image_ctx = &hs;
+    }
+
+    if (rc == ESP_OK)
+        rc = ota_stream(image_read, image_ctx, size, progress, res);
+    if (rc == ESP_OK)
+        rc = ota_finish(res, expected_sha256);
+
+end:
+    ota_hs_deinit(&hs);
+    device_pm_lock_release(ota_pm_lock);
+    xSemaphoreGive(ota_mutex);
+    return rc;
+}
+
+static int ota_httpd_read(void *ctx, char *buf, size_t len)
+{
+    int rc;
+
+    for (int retry = 0; retry < OTA_RECV_RETRIES; retry++) {
+        rc = httpd_req_recv(ctx, buf, len);
+        if (rc != HTTPD_SOCK_ERR_TIMEOUT)
+            return rc;
+    }
+    return rc;
+}
+
+// handler runs in httpd task, so events can be sent right away
+static void ota_httpd_progress(size_t bytes, size_t size, uint32_t bytes_per_sec)
+{
+    char data[80];
+
+    snprintf(data, sizeof(data), "{\"bytes\":%u,\"size\":%u,\"bytes_per_sec\":%" PRIu32 "}",
+             (unsigned)bytes, (unsigned)size, bytes_per_sec);
+    sse_send_event("ota", data);
+}
+
+esp_err_t ota_httpd_handler(httpd_req_t *req)
+{
+    struct ota_result res;
+    uint8_t           expected[32];
+    bool              verify = false;
+    char              hex[65];
+    char              resp[192];
+    esp_err_t         rc;
+
+    if (httpd_req_get_hdr_value_str(req, OTA_SHA256_HEADER, hex, sizeof(hex)) == ESP_OK) {
+        if (ota_sha256_from_hex(hex, expected) != ESP_OK) {
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "bad " OTA_SHA256_HEADER);
+            return ESP_FAIL;
+        }
+        verify = true;
+    }
+
+    rc = ota_update(ota_httpd_read, req, req->content_len, ota_httpd_progress,
+                    verify ? expected : NULL, &res);
+
+    ota_sha256_to_hex(res.sha256, hex);
+    ESP_LOGI(TAG, "%s: %u bytes, %" PRIu32 " B/s, sha256 %s", esp_err_to_name(rc),
+             (unsigned)res.bytes, res.bytes_per_sec, hex);
+
+    snprintf(resp, sizeof(resp),
+             "{\"result\":\"%s\",\"bytes_uploaded\":%u,\"bytes_per_sec\":%" PRIu32
+             ",\"sha256\":\"%s\"}",
+             esp_err_to_name(rc), (unsigned)res.bytes, res.bytes_per_sec, hex);
+    sse_send_event("ota", resp);
+
+    httpd_resp_set_type(req, HTTPD_TYPE_JSON);
+    httpd_resp_sendstr(req, resp);
+    if (rc == ESP_OK)
+        ota_restart_later();
+    return ESP_OK;
+}
@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2025 <qb4.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#ifndef MAIN_OTA_H_
+#define MAIN_OTA_H_
+
+#include <stdint.h>
+#include <esp_http_server.h>
+
+// returns number of bytes read, 0 or less on error
+typedef int (*ota_read_fn)(void *ctx, char *buf, size_t len);
+typedef void (*ota_progress_fn)(size_t bytes, size_t size, uint32_t bytes_per_sec);
+
+struct ota_result {
+    size_t   bytes; // written to flash
+    uint32_t bytes_per_sec;
+    uint8_t  sha256[32];
+};
+
+esp_err_t ota_init(void);
+
+/**
+ * @brief Write image read from source to the inactive OTA slot and make it bootable
+ *
+ * Image is a raw application image or one compressed with ota_compress.py,
+ * which is decompressed on the fly. Source is read into one buffer while the
+ * other one is written to flash, SHA-256 of written image is computed on the
+ * fly and checked against expected_sha256 when given.
+ *
+ * @param len source length, i.e. compressed size for compressed images
+ * @return ESP_ERR_INVALID_STATE when another update is in progress
+ */
+esp_err_t ota_update(ota_read_fn read, void *ctx, size_t len, ota_progress_fn progress,
+                     const uint8_t *expected_sha256, struct ota_result *res);
+
+/**
+ * @brief Restart into the new image after a short delay
+ *
+ */
+void ota_restart_later(void);
+
+void      ota_sha256_to_hex(const uint8_t *sha256, char *hex);
+esp_err_t ota_sha256_from_hex(const char *hex, uint8_t *sha256);
+
+/**
+ * @brief Receive firmware image uploaded to /update
+ *
+ * Request body is the image (application/octet-stream), expected hash can be
+ * passed in X-Firmware-SHA256 header. Progress is pushed to /events
+ * subscribers as "ota" events. Device restarts into the new image on success.
+ */
+esp_err_t ota_httpd_handler(httpd_req_t *req);
+
+#endif /* MAIN_OTA_H_ */
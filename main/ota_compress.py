@@ -0,0 +1,175 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2025 <qb4.dev@gmail.com>
+#
+# SPDX-License-Identifier: LGPL-2.1-or-later
+#
+# Compress application image for upload to /update, see ota_hs.h for format.
+# Payload is a plain heatshrink stream, same as `heatshrink -e -w W -l L`.
+# Optionally writes manifest.json for pull updates (CONFIG_APP_OTA_PULL).
+
+import argparse
+import hashlib
+import json
+import os
+import struct
+import sys
+
+MAGIC = b'ESHS'
+HEADER = struct.Struct('<4sBBHI')
+
+
+class BitWriter:
+    def __init__(self):
+        self.out = bytearray()
+        self.byte = 0
+        self.count = 0
+
+    def put(self, val, bits):
+        for i in reversed(range(bits)):
+            self.byte = self.byte << 1 | (val >> i) & 1
+            self.count += 1
+            if self.count == 8:
+                self.out.append(self.byte)
+                self.byte = 0
+                self.count = 0
+
+    def flush(self):
+        if self.count:
+            self.out.append(self.byte << (8 - self.count))
+        return bytes(self.out)
+
+
+class BitReader:
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def get(self, bits):
+        val = 0
+        for _ in range(bits):
+            if self.pos >= len(self.data) * 8:
+                return None
+            val = val << 1 | self.data[self.pos >> 3] >> (7 - (self.pos & 7)) & 1
+            self.pos += 1
+        return val
+
+
+def encode(data, window_sz2, lookahead_sz2):
+    window = 1 << window_sz2
+    max_len = 1 << lookahead_sz2
+    # back-reference must be cheaper than literals it replaces
+    min_len = (1 + window_sz2 + lookahead_sz2) // 9 + 1
+    bw = BitWriter()
+    chains = {}
+    i = 0
+
+    def insert(pos):
+        if pos + min_len <= len(data):
+            chains.setdefault(data[pos:pos + min_len], []).append(pos)
+
+    while i < len(data):
+        best_len, best_pos = 0, 0
+        limit = min(max_len, len(data) - i)
+        if limit >= min_len:
+            for pos in reversed(chains.get(data[i:i + min_len], [])):
+                if i - pos > window:
+                    break
+                n = min_len
+                while n < limit and data[pos + n] == data[i + n]:
+                    n += 1
+                if n > best_len:
+                    best_len, best_pos = n, pos
+                    if n == limit:
+                        break
+        if best_len:
+            bw.put(0, 1)
+            bw.put(i - best_pos - 1, window_sz2)
+            bw.put(best_len - 1, lookahead_sz2)
+            for pos in range(i, i + best_len):
+                insert(pos)
+            i += best_len
+        else:
+            bw.put(1, 1)
+            bw.put(data[i], 8)
+            insert(i)
+            i += 1
+    return bw.flush()
+
+
+def decode(stream, size, window_sz2, lookahead_sz2):
+    br = BitReader(stream)
+    out = bytearray()
+    while len(out) < size:
+        tag = br.get(1)
+        if tag is None:
+            break
+        if tag:
+            out.append(br.get(8))
+            continue
+        offset = br.get(window_sz2) + 1
+        count = br.get(lookahead_sz2) + 1
+        for _ in range(count):
+            # window is zero filled before first byte
+            out.append(out[-offset] if offset <= len(out) else 0)
+    return bytes(out[:size])
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument('image', help='application image, e.g. build/<project>.bin')
+    parser.add_argument('-o', '--output', help='output file, default <image>.hs')
+    parser.add_argument('-w', '--window', type=int, default=10, choices=range(4, 13),
+                        metavar='4-12', help='window size log2 (default 10)')
+    parser.add_argument('-l', '--lookahead', type=int, default=5, metavar='3-W',
+                        help='lookahead size log2 (default 5)')
+    parser.add_argument('--verify', action='store_true', help='decompress and compare')
+    parser.add_argument('--manifest', metavar='VERSION',
+                        help='write manifest.json for pull update next to output')
+    parser.add_argument('--raw', action='store_true',
+                        help='do not compress, manifest points to image itself')
+    args = parser.parse_args()
+
+    if not 3 <= args.lookahead < args.window:
+        parser.error('lookahead must be between 3 and window - 1')
+
+    with open(args.image, 'rb') as f:
+        data = f.read()
+    if not data or data[0] != 0xE9:
+        print('warning: %s does not look like an application image' % args.image,
+              file=sys.stderr)
+
+    if args.raw:
+        out = args.image
+        size = len(data)
+    else:
+        stream = encode(data, args.window, args.lookahead)
+        if args.verify and decode(stream, len(data), args.window, args.lookahead) != data:
+            sys.exit('%s: round-trip mismatch' % args.image)
+
+        out = args.output or args.image + '.hs'
+        with open(out, 'wb') as f:
+            f.write(HEADER.pack(MAGIC, args.window, args.lookahead, 0, len(data)))
+            f.write(stream)
+
+        size = HEADER.size + len(stream)
+        ratio = 100.0 * size / max(len(data), 1)  # empty image is valid input
+        print('%s: %d -> %d bytes (%.1f%%)%s' % (out, len(data), size, ratio,
+                                                 ', verified' if args.verify else ''))
+
+    if args.manifest:
+        # hash is checked on image written to flash, i.e. after decompression
+        manifest = {
+            'version': args.manifest,
+            'size': size,
+            'sha256': hashlib.sha256(data).hexdigest(),
+            'url': os.path.basename(out),
+        }
+        path = os.path.join(os.path.dirname(os.path.abspath(out)), 'manifest.json')
+        with open(path, 'w') as f:
+            json.dump(manifest, f, indent=2)
+        print('%s: %s' % (path, args.manifest))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2025 <qb4.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "ota_hs.h"
+#include <stdlib.h>
+#include <string.h>
+
+// no ESP dependencies here, file builds on host for round-trip checks
+
+esp_err_t ota_hs_parse_header(const uint8_t *hdr, uint8_t *window_sz2, uint8_t *lookahead_sz2,
+                              uint32_t *size)
+{
+    if (memcmp(hdr, OTA_HS_MAGIC, 4))
+        return ESP_ERR_NOT_FOUND;
+
+    *window_sz2 = hdr[4];
+    *lookahead_sz2 = hdr[5];
+    *size = hdr[8] | hdr[9] << 8 | hdr[10] << 16 | (uint32_t)hdr[11] << 24;
+    if (*window_sz2 < 4 || *window_sz2 > OTA_HS_WINDOW_SZ2_MAX || *lookahead_sz2 < 3 ||
+        *lookahead_sz2 >= *window_sz2)
+        return ESP_ERR_NOT_SUPPORTED;
+    return ESP_OK;
+}
+
+esp_err_t ota_hs_init(ota_hs_t *hs, uint8_t window_sz2, uint8_t lookahead_sz2,
+                      ota_hs_read_fn read, void *ctx)
+{
+    memset(hs, 0, sizeof(*hs));
+    // encoder assumes zero filled window before first byte
+    hs->window = calloc(1, 1 << window_sz2);
+    if (!hs->window)
+        return ESP_ERR_NO_MEM;
+
+    hs->mask = (1 << window_sz2) - 1;
+    hs->window_sz2 = window_sz2;
+    hs->lookahead_sz2 = lookahead_sz2;
+    hs->read = read;
+    hs->ctx = ctx;
+    return ESP_OK;
+}
+
+void ota_hs_deinit(ota_hs_t *hs)
+{
+    free(hs->window);
+    hs->window = NULL;
+}
+
+// bits are packed MSB first, returns -1 when input ends
+static int hs_get_bits(ota_hs_t *hs, uint8_t count)
+{
+    int val = 0;
+    int n;
+
+    while (count--) {
+        if (!hs->bits_left) {
+            if (hs->in_pos == hs->in_len) {
+                n = hs->read(hs->ctx, (char *)hs->in, sizeof(hs->in));
+                if (n <= 0)
+                    return -1;
+                hs->in_len = n;
+                hs->in_pos = 0;
+            }
+            hs->bits = hs->in[hs->in_pos++];
+            hs->bits_left = 8;
+        }
+        val = val << 1 | hs->bits >> 7;
+        hs->bits <<= 1;
+        hs->bits_left--;
+    }
+    return val;
+}
+
+int ota_hs_read(void *ctx, char *buf, size_t len)
+{
+    ota_hs_t *hs = ctx;
+    size_t    n = 0;
+    int       tag, val, count;
+    uint8_t   byte;
+
+    while (n < len) {
+        if (hs->copy_count) {
+            byte = hs->window[(hs->pos - hs->copy_offset) & hs->mask];
+            hs->copy_count--;
+        } else {
+            // 1: literal byte, 0: back-reference (index - 1, count - 1)
+            tag = hs_get_bits(hs, 1);
+            if (tag < 0)
+                break;
+            if (tag) {
+                val = hs_get_bits(hs, 8);
+                if (val < 0)
+                    break;
+                byte = val;
+            } else {
+                val = hs_get_bits(hs, hs->window_sz2);
+                count = hs_get_bits(hs, hs->lookahead_sz2);
+                if (val < 0 || count < 0)
+                    break;
+                hs->copy_offset = val + 1;
+                hs->copy_count = count + 1;
+                continue;
+            }
+        }
+        hs->window[hs->pos++ & hs->mask] = byte;
+        buf[n++] = byte;
+    }
+    return n;
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2025 <qb4.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#ifndef MAIN_OTA_HS_H_
+#define MAIN_OTA_HS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <esp_err.h>
+
+/*
+ * Compressed image is a 12 byte header followed by heatshrink stream:
+ *  0  "ESHS"
+ *  4  window size (log2), 4..OTA_HS_WINDOW_SZ2_MAX
+ *  5  lookahead size (log2), 3..window-1
+ *  6  reserved, 0
+ *  8  uncompressed image size, little endian
+ * Images are made with ota_compress.py.
+ */
+#define OTA_HS_MAGIC "ESHS"
+#define OTA_HS_HEADER_SIZE 12
+#define OTA_HS_WINDOW_SZ2_MAX 12
+
+typedef int (*ota_hs_read_fn)(void *ctx, char *buf, size_t len);
+
+typedef struct {
+    ota_hs_read_fn read; // compressed input
+    void          *ctx;
+    uint8_t       *window;
+    uint16_t       mask;
+    uint8_t        window_sz2;
+    uint8_t        lookahead_sz2;
+    uint32_t       pos;
+    uint16_t       copy_count;
+    uint16_t       copy_offset;
+    uint8_t        in[64];
+    uint8_t        in_len;
+    uint8_t        in_pos;
+    uint8_t        bits;
+    uint8_t        bits_left;
+} ota_hs_t;
+
+/**
+ * @brief Check image header
+ *
+ * @return ESP_ERR_NOT_FOUND when image is not compressed
+ */
+esp_err_t ota_hs_parse_header(const uint8_t *hdr, uint8_t *window_sz2, uint8_t *lookahead_sz2,
+                              uint32_t *size);
+
+esp_err_t ota_hs_init(ota_hs_t *hs, uint8_t window_sz2, uint8_t lookahead_sz2,
+                      ota_hs_read_fn read, void *ctx);
+void      ota_hs_deinit(ota_hs_t *hs);
+
+/**
+ * @brief Read decompressed data, input is pulled from source as needed
+ *
+ * @return number of bytes, 0 or less when input ended or failed
+ */
+int ota_hs_read(void *ctx, char *buf, size_t len);
+
+#endif /* MAIN_OTA_HS_H_ */
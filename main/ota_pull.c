@@ -0,0 +1,359 @@
+/*
+ * Copyright (c) 2025 <qb4.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "ota_pull.h"
+#include "ota.h"
+#include "ota_pull_dl.h"
+#include "stats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <esp_log.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+#include <esp_ota_ops.h>
+#include <esp_http_client.h>
+#include <nvs.h>
+#include <cJSON.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <device.h>
+
+#ifdef CONFIG_APP_OTA_PULL
+
+#define OTA_PULL_NVS_NAMESPACE "ota_pull"
+#define OTA_PULL_NVS_TRIAL_KEY "trial" // boots of image on trial
+#define OTA_PULL_NVS_BAD_KEY "bad_ver" // last rolled back version
+
+#define OTA_PULL_BOOT_ATTEMPTS 3
+#define OTA_PULL_FIRST_CHECK_MS (30 * 1000)
+#define OTA_PULL_TIMEOUT_MS (10 * 1000)
+#define OTA_PULL_RETRIES 5
+#define OTA_PULL_RETRY_DELAY_MS (2 * 1000)
+#define OTA_PULL_MANIFEST_MAX 512
+#define OTA_PULL_URL_MAX 256
+#define OTA_PULL_VERSION_MAX 32
+
+static const char *TAG = "OTA-PULL";
+
+struct ota_manifest {
+    char     version[OTA_PULL_VERSION_MAX];
+    char     url[OTA_PULL_URL_MAX];
+    uint32_t size;
+    uint8_t  sha256[32];
+};
+
+static volatile supla_dev_state_t supla_state = SUPLA_DEV_STATE_IDLE;
+static volatile bool              trial;
+static esp_timer_handle_t         health_timer;
+static TaskHandle_t               pull_task;
+
+static esp_err_t ota_pull_nvs_trial_set(uint8_t boots)
+{
+    nvs_handle_t nvs;
+    esp_err_t    rc;
+
+    rc = nvs_open(OTA_PULL_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (rc != ESP_OK)
+        return rc;
+
+    rc = nvs_set_u8(nvs, OTA_PULL_NVS_TRIAL_KEY, boots);
+    if (rc == ESP_OK)
+        rc = nvs_commit(nvs);
+    nvs_close(nvs);
+    device_metrics_nvs_write();
+    return rc;
+}
+
+static esp_err_t ota_pull_nvs_trial_end(const char *bad_version)
+{
+    nvs_handle_t nvs;
+    esp_err_t    rc;
+
+    rc = nvs_open(OTA_PULL_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (rc != ESP_OK)
+        return rc;
+
+    nvs_erase_key(nvs, OTA_PULL_NVS_TRIAL_KEY);
+    if (bad_version)
+        nvs_set_str(nvs, OTA_PULL_NVS_BAD_KEY, bad_version);
+    rc = nvs_commit(nvs);
+    nvs_close(nvs);
+    device_metrics_nvs_write();
+    return rc;
+}
+
+static bool ota_pull_is_bad_version(const char *version)
+{
+    nvs_handle_t nvs;
+    char         bad[OTA_PULL_VERSION_MAX];
+    size_t       len = sizeof(bad);
+    esp_err_t    rc;
+
+    if (nvs_open(OTA_PULL_NVS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK)
+        return false;
+    rc = nvs_get_str(nvs, OTA_PULL_NVS_BAD_KEY, bad, &len);
+    nvs_close(nvs);
+    return rc == ESP_OK && !strcmp(bad, version);
+}
+
+// returns only when there is no image to roll back to
+static void ota_pull_rollback(void)
+{
+    const esp_partition_t *prev = esp_ota_get_next_update_partition(NULL);
+
+    if (!prev) {
+        ESP_LOGE(TAG, "image %s failed health check, no partition to roll back to",
+                 app_get_description()->version);
+        trial = false;
+        ota_pull_nvs_trial_end(NULL);
+        return;
+    }
+    ESP_LOGE(TAG, "image %s failed health check, rolling back to %s",
+             app_get_description()->version, prev->label);
+    ota_pull_nvs_trial_end(app_get_description()->version);
+#ifdef CONFIG_BOOTLOADER_APP_ROLLBACK_ENABLE
+    esp_ota_mark_app_invalid_rollback_and_reboot();
+#endif
+    esp_ota_set_boot_partition(prev);
+    esp_restart();
+}
+
+static void health_timer_cb(void *arg)
+{
+    // suspended in config mode, restarted on exit
+    if (trial && !(device_get_event_bits() & DEVICE_CONFIG_EVENT_BIT))
+        ota_pull_rollback();
+}
+
+esp_err_t ota_pull_init(void)
+{
+    esp_timer_create_args_t timer_args = {
+        .name = "ota_health",
+        .dispatch_method = ESP_TIMER_TASK,
+        .callback = health_timer_cb,
+    };
+    nvs_handle_t nvs;
+    uint8_t      boots;
+    esp_err_t    rc;
+
+    rc = esp_timer_create(&timer_args, &health_timer);
+    if (rc != ESP_OK)
+        return rc;
+
+    if (nvs_open(OTA_PULL_NVS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK)
+        return ESP_OK;
+    rc = nvs_get_u8(nvs, OTA_PULL_NVS_TRIAL_KEY, &boots);
+    nvs_close(nvs);
+    if (rc != ESP_OK)
+        return ESP_OK; // image confirmed
+
+    // image crashing before timeout is caught by boot counter
+    if (++boots > OTA_PULL_BOOT_ATTEMPTS) {
+        ota_pull_rollback();
+        return ESP_OK;
+    }
+    ota_pull_nvs_trial_set(boots);
+
+    trial = true;
+    ESP_LOGW(TAG, "image %s on trial, boot %d, must get online within %d s",
+             app_get_description()->version, boots, CONFIG_APP_OTA_PULL_HEALTH_TIMEOUT_S);
+    return esp_timer_start_once(health_timer, CONFIG_APP_OTA_PULL_HEALTH_TIMEOUT_S * 1000000ULL);
+}
+
+void ota_pull_supla_state(supla_dev_state_t state)
+{
+    supla_state = state;
+    if (state != SUPLA_DEV_STATE_ONLINE || !trial)
+        return;
+
+    trial = false;
+    esp_timer_stop(health_timer);
+    ota_pull_nvs_trial_end(NULL);
+#ifdef CONFIG_BOOTLOADER_APP_ROLLBACK_ENABLE
+    esp_ota_mark_app_valid_cancel_rollback();
+#endif
+    ESP_LOGI(TAG, "image %s confirmed", app_get_description()->version);
+}
+
+void ota_pull_config_mode(bool active)
+{
+    if (!trial)
+        return;
+
+    // time spent configuring does not count, image gets full timeout after
+    esp_timer_stop(health_timer);
+    if (!active) {
+        esp_timer_start_once(health_timer, CONFIG_APP_OTA_PULL_HEALTH_TIMEOUT_S * 1000000ULL);
+        ESP_LOGI(TAG, "health check restarted, %d s", CONFIG_APP_OTA_PULL_HEALTH_TIMEOUT_S);
+    }
+}
+
+// relative manifest urls are resolved against manifest location
+static void ota_pull_resolve_url(const char *url, char *out, size_t size)
+{
+    const char *base = CONFIG_APP_OTA_PULL_URL;
+    const char *host = strstr(base, "://");
+    const char *end;
+
+    if (strstr(url, "://") || !host) {
+        snprintf(out, size, "%s", url);
+        return;
+    }
+    if (url[0] == '/') {
+        end = strchr(host + 3, '/');
+        if (!end)
+            end = base + strlen(base);
+        snprintf(out, size, "%.*s%s", (int)(end - base), base, url);
+    } else {
+        end = strrchr(host + 3, '/');
+        if (!end)
+            end = base + strlen(base);
+        snprintf(out, size, "%.*s/%s", (int)(end - base), base, url);
+    }
+}
+
+static esp_err_t ota_pull_parse_manifest(const char *data, struct ota_manifest *m)
+{
+    cJSON    *js = cJSON_Parse(data);
+    cJSON    *version, *size, *sha256, *url;
+    esp_err_t rc = ESP_ERR_INVALID_RESPONSE;
+
+    if (!js)
+        return rc;
+
+    version = cJSON_GetObjectItem(js, "version");
+    size = cJSON_GetObjectItem(js, "size");
+    sha256 = cJSON_GetObjectItem(js, "sha256");
+    url = cJSON_GetObjectItem(js, "url");
+    if (cJSON_IsString(version) && cJSON_IsNumber(size) && cJSON_IsString(sha256) &&
+        cJSON_IsString(url) && size->valuedouble > 0 &&
+        ota_sha256_from_hex(sha256->valuestring, m->sha256) == ESP_OK) {
+        snprintf(m->version, sizeof(m->version), "%s", version->valuestring);
+        ota_pull_resolve_url(url->valuestring, m->url, sizeof(m->url));
+        m->size = size->valuedouble;
+        rc = ESP_OK;
+    }
+    cJSON_Delete(js);
+    return rc;
+}
+
+static esp_err_t ota_pull_get_manifest(struct ota_manifest *m)
+{
+    esp_http_client_config_t config = {
+        .url = CONFIG_APP_OTA_PULL_URL,
+        .timeout_ms = OTA_PULL_TIMEOUT_MS,
+    };
+    esp_http_client_handle_t client = esp_http_client_init(&config);
+    char                    *buf = NULL;
+    int                      len, n;
+    esp_err_t                rc;
+
+    if (!client)
+        return ESP_ERR_NO_MEM;
+
+    rc = esp_http_client_open(client, 0);
+    if (rc != ESP_OK)
+        goto end;
+
+    len = esp_http_client_fetch_headers(client);
+    if (esp_http_client_get_status_code(client) != 200 || len <= 0 ||
+        len > OTA_PULL_MANIFEST_MAX) {
+        rc = ESP_ERR_INVALID_RESPONSE;
+        goto end;
+    }
+
+    buf = calloc(1, len + 1);
+    if (!buf) {
+        rc = ESP_ERR_NO_MEM;
+        goto end;
+    }
+    for (int got = 0; got < len; got += n) {
+        n = esp_http_client_read(client, buf + got, len - got);
+        if (n <= 0) {
+            rc = ESP_FAIL;
+            goto end;
+        }
+    }
+    rc = ota_pull_parse_manifest(buf, m);
+
+end:
+    free(buf);
+    esp_http_client_cleanup(client);
+    return rc;
+}
+
+static esp_err_t ota_pull_check(void)
+{
+    static struct ota_manifest m;
+    esp_http_client_config_t   config = {
+        .url = m.url,
+        .timeout_ms = OTA_PULL_TIMEOUT_MS,
+    };
+    const char       *running = app_get_description()->version;
+    ota_pull_dl_t     dl = {
+        .retries = OTA_PULL_RETRIES,
+        .retry_delay_ms = OTA_PULL_RETRY_DELAY_MS,
+    };
+    struct ota_result res;
+    esp_err_t         rc;
+
+    rc = ota_pull_get_manifest(&m);
+    if (rc != ESP_OK) {
+        ESP_LOGW(TAG, "manifest: %s", esp_err_to_name(rc));
+        return rc;
+    }
+    if (!strcmp(m.version, running))
+        return ESP_OK;
+    if (ota_pull_is_bad_version(m.version)) {
+        ESP_LOGD(TAG, "%s was rolled back, skipped", m.version);
+        return ESP_OK;
+    }
+
+    ESP_LOGI(TAG, "updating %s -> %s from %s", running, m.version, m.url);
+    dl.client = esp_http_client_init(&config);
+    if (!dl.client)
+        return ESP_ERR_NO_MEM;
+
+    rc = ota_pull_dl_open(&dl);
+    if (rc == ESP_OK)
+        rc = ota_update(ota_pull_dl_read, &dl, m.size, NULL, m.sha256, &res);
+    esp_http_client_cleanup(dl.client);
+    if (rc != ESP_OK) {
+        ESP_LOGE(TAG, "update failed: %s", esp_err_to_name(rc));
+        return rc;
+    }
+
+    ESP_LOGI(TAG, "%u bytes written, %u B/s, restarting", (unsigned)res.bytes,
+             (unsigned)res.bytes_per_sec);
+    ota_pull_nvs_trial_set(0);
+    ota_restart_later();
+    return ESP_OK;
+}
+
+static void ota_pull_task(void *arg)
+{
+    vTaskDelay(pdMS_TO_TICKS(OTA_PULL_FIRST_CHECK_MS));
+    for (;;) {
+        // image on trial is never replaced before it is confirmed
+        if (supla_state == SUPLA_DEV_STATE_ONLINE && !trial)
+            ota_pull_check();
+        for (int i = 0; i < CONFIG_APP_OTA_PULL_INTERVAL_MIN; i++)
+            vTaskDelay(pdMS_TO_TICKS(60 * 1000));
+    }
+}
+
+esp_err_t ota_pull_start(void)
+{
+    if (pull_task)
+        return ESP_OK;
+    if (xTaskCreate(ota_pull_task, "ota_pull", 4096, NULL, tskIDLE_PRIORITY + 1, &pull_task) !=
+        pdPASS)
+        return ESP_ERR_NO_MEM;
+    return ESP_OK;
+}
+
+#endif /* CONFIG_APP_OTA_PULL */
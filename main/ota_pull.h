@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2025 <qb4.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#ifndef MAIN_OTA_PULL_H_
+#define MAIN_OTA_PULL_H_
+
+#include <stdbool.h>
+#include <esp_err.h>
+#include <esp-supla.h>
+
+/**
+ * @brief Start health check of image installed by previous pull update
+ *
+ * Image which does not get SUPLA_DEV_STATE_ONLINE within
+ * CONFIG_APP_OTA_PULL_HEALTH_TIMEOUT_S, or restarts too many times before,
+ * is rolled back and its version is not pulled again. Call early in boot,
+ * after NVS init.
+ */
+esp_err_t ota_pull_init(void);
+
+/**
+ * @brief Start polling CONFIG_APP_OTA_PULL_URL manifest
+ *
+ * Manifest is checked only while device is online. Download resumes with
+ * HTTP Range requests after interruptions.
+ */
+esp_err_t ota_pull_start(void);
+
+/**
+ * @brief Track SUPLA connection state, confirms image on trial when online
+ *
+ */
+void ota_pull_supla_state(supla_dev_state_t state);
+
+/**
+ * @brief Suspend health check of image on trial while in config mode
+ *
+ * Health timeout starts over when config mode is left.
+ */
+void ota_pull_config_mode(bool active);
+
+#endif /* MAIN_OTA_PULL_H_ */
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2025 <qb4.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "ota_pull_dl.h"
+#include <stdio.h>
+#include <esp_log.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#ifdef CONFIG_APP_OTA_PULL
+
+static const char *TAG = "OTA-PULL";
+
+esp_err_t ota_pull_dl_open(ota_pull_dl_t *dl)
+{
+    char      range[32];
+    char      skip[64];
+    int       status, n;
+    esp_err_t rc;
+
+    if (dl->offset) {
+        snprintf(range, sizeof(range), "bytes=%u-", (unsigned)dl->offset);
+        esp_http_client_set_header(dl->client, "Range", range);
+    }
+
+    rc = esp_http_client_open(dl->client, 0);
+    if (rc != ESP_OK)
+        return rc;
+    if (esp_http_client_fetch_headers(dl->client) < 0)
+        return ESP_FAIL;
+
+    status = esp_http_client_get_status_code(dl->client);
+    if (status == 206 && dl->offset)
+        return ESP_OK;
+    if (status != 200)
+        return ESP_ERR_INVALID_RESPONSE;
+
+    // server ignores Range, skip what is already written
+    for (size_t skipped = 0; skipped < dl->offset; skipped += n) {
+        n = esp_http_client_read(dl->client, skip,
+                                 dl->offset - skipped < sizeof(skip) ? dl->offset - skipped :
+                                                                       sizeof(skip));
+        if (n <= 0)
+            return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+int ota_pull_dl_read(void *ctx, char *buf, size_t len)
+{
+    ota_pull_dl_t *dl = ctx;
+    int            n;
+
+    for (;;) {
+        n = esp_http_client_read(dl->client, buf, len);
+        if (n > 0) {
+            dl->offset += n;
+            return n;
+        }
+        do {
+            if (dl->retries-- <= 0)
+                return -1;
+            ESP_LOGW(TAG, "download interrupted at %u bytes, resuming", (unsigned)dl->offset);
+            esp_http_client_close(dl->client);
+            vTaskDelay(pdMS_TO_TICKS(dl->retry_delay_ms));
+        } while (ota_pull_dl_open(dl) != ESP_OK);
+    }
+}
+
+#endif /* CONFIG_APP_OTA_PULL */
@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) 2025 <qb4.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#ifndef MAIN_OTA_PULL_DL_H_
+#define MAIN_OTA_PULL_DL_H_
+
+#include <stddef.h>
+#include <esp_err.h>
+#include <esp_http_client.h>
+
+/*
+ * Image download which survives interrupted transfers: it is reopened with
+ * HTTP Range request from the last byte read. Servers ignoring Range answer
+ * with whole image, bytes already read are skipped then.
+ */
+typedef struct {
+    esp_http_client_handle_t client;
+    size_t                   offset;         // bytes returned by ota_pull_dl_read()
+    int                      retries;        // reopen attempts left
+    uint32_t                 retry_delay_ms; // before each reopen
+} ota_pull_dl_t;
+
+/**
+ * @brief Open download at dl->offset
+ *
+ * @return ESP_OK when body is ready to read, ESP_ERR_INVALID_RESPONSE on HTTP error status
+ */
+esp_err_t ota_pull_dl_open(ota_pull_dl_t *dl);
+
+/**
+ * @brief Read image data, reopens download when transfer is interrupted
+ *
+ * Never ask past image end, end of stream is taken as interruption.
+ * Usable as ota_read_fn.
+ *
+ * @return bytes read, -1 when retries are exhausted
+ */
+int ota_pull_dl_read(void *ctx, char *buf, size_t len);
+
+#endif /* MAIN_OTA_PULL_DL_H_ */
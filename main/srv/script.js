@@ -16,90 +16,160 @@ function reset(e) {
     }
 }
 
+let devStats = null;
+
+function secToTime(e){
+	const h = Math.floor(e / 3600).toString().padStart(2,'0'),
+	m = Math.floor(e % 3600 / 60).toString().padStart(2,'0'),
+	s = Math.floor(e % 60).toString().padStart(2,'0');
+	return h + ':' + m + ':' + s;
+}
+
+function showSuplaStats(){
+	if(!devStats)
+		return;
+
+	const div = document.getElementById('device');
+	// uptimes advance locally between device updates
+	const elapsed = (Date.now() - devStats.received) / 1000;
+
+	let stats = `<small>
+	Device: ${devStats.name}<br>
+	software: ${devStats.software_ver}<br>
+	state: ${devStats.state}<br>
+	GUID: ${devStats.guid}<br>
+	uptime: ${secToTime(devStats.uptime + elapsed)}<br>
+	connection uptime: ${secToTime(devStats.connection_uptime + elapsed)}
+	</small>`;
+	document.getElementById("default").innerHTML = devStats.name;
+	div.innerHTML = stats;
+}
+
 function suplaStats(){
 	fetch(esp_url+"/supla")
 	.then(r => r.json())
 	.then(js => {
-		const div = document.getElementById('device');
+		devStats = js.data;
+		devStats.received = Date.now();
+		showSuplaStats();
+	});
+}
 
-		function secToTime(e){
-			const h = Math.floor(e / 3600).toString().padStart(2,'0'),
-			m = Math.floor(e % 3600 / 60).toString().padStart(2,'0'),
-			s = Math.floor(e % 60).toString().padStart(2,'0');
-			return h + ':' + m + ':' + s;
-		}
+function showNetStats(sta){
+	const div = document.getElementById('net');
 
-		let stats = `<small>
-		Device: ${js.data.name}<br>
-		software: ${js.data.software_ver}<br>
-		state: ${js.data.state}<br>
-		GUID: ${js.data.guid}<br>
-		uptime: ${secToTime(js.data.uptime)}<br>
-		connection uptime: ${secToTime(js.data.connection_uptime)}
-		</small>`;
-		document.getElementById("default").innerHTML = js.data.name;
-		div.innerHTML = stats;
-		return setTimeout(suplaStats, 2000);
-	});
+	let stats = `
+		<small>
+			Status: ${sta.status}<br>`;
+	if(sta.connection)
+		stats += `
+			Network: ${sta.connection.ssid}<br>
+			authmode: ${sta.connection.authmode}<br>
+			RSSI: <span id="rssi">${sta.connection.rssi}</span> dB<br>`;
+
+	stats +=`
+		IP addr: ${sta.ip_info.ip}<br>
+		netmask: ${sta.ip_info.netmask}<br>
+		gateway: ${sta.ip_info.gw}
+	</small>`;
+
+	div.innerHTML = stats;
 }
 
 function netStats(){
-	fetch(esp_url+"/wifi")
+	fetch(esp_url+"/status")
 	.then(r => r.json())
-	.then(js => {
-		const div = document.getElementById('net');
-		let sta = js.data.sta;
-
-		let stats = `
-			<small>
-				Status: ${sta.status}<br>`;
-		if(sta.connection)
-			stats += `
-				Network: ${sta.connection.ssid}<br>
-				authmode: ${sta.connection.authmode}<br>
-				RSSI: ${sta.connection.rssi} dB<br>`;
-
-		stats +=`
-			IP addr: ${sta.ip_info.ip}<br>
-			netmask: ${sta.ip_info.netmask}<br>
-			gateway: ${sta.ip_info.gw}
-		</small>`;
-
-		div.innerHTML = stats;
-		return setTimeout(netStats, 2000);
+	.then(js => showNetStats(js.wifi.sta));
+}
+
+function channelEvent(js){
+	const div = document.getElementById('channels');
+	let item = document.getElementById('ch-'+js.number);
+
+	if(!item){
+		item = document.createElement('div');
+		item.id = 'ch-'+js.number;
+		div.appendChild(item);
+	}
+	item.innerHTML = `<small>channel ${js.number}: ${js.event} ${js.code}</small>`;
+}
+
+function liveStats(){
+	suplaStats();
+	setInterval(showSuplaStats, 1000);
+
+	if(!window.EventSource){
+		setInterval(() => { suplaStats(); netStats(); }, 2000);
+		return;
+	}
+
+	// device pushes status only when it changes, full stats are fetched on state change
+	let state = null;
+	const es = new EventSource(esp_url+"/events");
+	es.addEventListener('status', e => {
+		const js = JSON.parse(e.data);
+		const rssi = document.getElementById('rssi');
+
+		if(state !== null && state !== js.state){
+			suplaStats();
+			netStats();
+		} else if(rssi) {
+			rssi.innerHTML = js.rssi;
+		}
+		state = js.state;
 	});
+	es.addEventListener('channel', e => channelEvent(JSON.parse(e.data)));
+	es.addEventListener('ota', e => otaProgress(JSON.parse(e.data)));
 }
 
-function getWiFiConfigForm(){
-	fetch(esp_url+"/wifi?action=get_config")
-	.then(r => r.json())
-	.then(js => {
-		const div = document.getElementById('wifi');
+function showWiFiConfigForm(sta){
+	const div = document.getElementById('wifi');
 
-		let html = `
-		<form id="wifi-form" method="post">
-			SSID<br>
-			<input type="text" name="ssid" value="${js.data.sta.ssid}" style="max-width:300px"><br>
-			Password<br>
-			<input type="password" name="passwd" style="max-width:300px"><br>
-			<input type="submit" value="submit">
-		</form>`;
+	let html = `
+	<form id="wifi-form" method="post">
+		SSID<br>
+		<input type="text" name="ssid" value="${sta.ssid}" list="wifi-aps" style="max-width:300px"><br>
+		<datalist id="wifi-aps"></datalist>
+		Password<br>
+		<input type="password" name="passwd" style="max-width:300px"><br>
+		<input type="submit" value="submit">
+	</form>`;
 
-		div.innerHTML = html;
-		const form = document.getElementById('wifi-form');
-		form.onsubmit = function(e){
-			e.preventDefault();
-			let data = decodeURIComponent(new URLSearchParams(new FormData(this)));
+	div.innerHTML = html;
+	const form = document.getElementById('wifi-form');
+	form.onsubmit = function(e){
+		e.preventDefault();
+		let data = decodeURIComponent(new URLSearchParams(new FormData(this)));
 
-			fetch(esp_url+"/wifi?action=connect",
-			{
-				method: "POST",
-				body: data
-			})
-			.then(r => r.json())
-			.then(js => { alert("WiFi config changed"); });
-		};
-	})
+		fetch(esp_url+"/wifi?action=connect",
+		{
+			method: "POST",
+			body: data
+		})
+		.then(r => r.json())
+		.then(js => { alert("WiFi config changed"); });
+	};
+	loadWiFiScan();
+}
+
+// scan runs in background, poll until fresh list is ready
+function loadWiFiScan(){
+	fetch(esp_url+"/wifi/scan")
+	.then(r => r.json())
+	.then(js => {
+		const list = document.getElementById('wifi-aps');
+		if(!list)
+			return;
+		// SSIDs come from anyone in range, never parse them as HTML
+		list.replaceChildren(...js.aps.map(ap => {
+			const option = document.createElement('option');
+			option.value = ap.ssid;
+			option.textContent = `${ap.rssi} dBm`;
+			return option;
+		}));
+		if(js.scanning)
+			setTimeout(loadWiFiScan, 3000);
+	});
 }
 
 function getSuplaConfigForm(){
@@ -136,88 +206,100 @@ function getSuplaConfigForm(){
 	})
 }
 
-function getSettingsForm(){
-	fetch(esp_url+"/settings")
-	.then(r => r.json())
-	.then(js => {
-		const div = document.getElementById('brd');
-
-		let html = `<form id="brd-form" method="post">`;
-		js.data.groups.forEach((gr, i) => {
-			html+=`${gr.label}:<br>`;
-			html+='<small>';
-			gr.settings.forEach((item, i) => {
-				switch (item.type) {
-					case "BOOL":
-						html+=`<input type="checkbox" name="${gr.id}:${item.id}" ${item.val?"checked":''}>${item.label}<br>`;
-						break;
-					case "NUM":
-						html+=`<span class="label-inline">${item.label}</span><input type="number" name="${gr.id}:${item.id}" min=${item.min} max=${item.max} value=${item.val} style="width:150px"><br>`;
-						break;
-					case "ONEOF":
-						html+=`<span class="label-inline">${item.label}</span><select name="${gr.id}:${item.id}" style="width:160px">`;
-						item.options.forEach((txt, i) => { html+=` <option value=${i} ${item.val==i?"selected":''}>${txt}</option>`;});
-						html+=`</select><br>`;
-						break;
-					case "TIME":
-						let time = String(item.hh).padStart(2,'0')+":"+String(item.mm).padStart(2,'0');
-						html+=`<span class="label-inline">${item.label}</span><input type="time" name="${gr.id}:${item.id}" min="00:00" max="23:59" value="${time}" style="width:150px"/><br>`;
-						break;
-					case "COLOR":
-						html+=`<span class="label-inline">${item.label}</span><input type="color" name="${gr.id}:${item.id}" value="${item.val}" style="width:50px"/><br>`;
-						break;
-					default:
-						break;
-				}
-			});
-			html+=`</small>`;
+function showSettingsForm(settings){
+	const div = document.getElementById('brd');
+
+	let html = `<form id="brd-form" method="post">`;
+	settings.groups.forEach((gr, i) => {
+		html+=`${gr.label}:<br>`;
+		html+='<small>';
+		gr.settings.forEach((item, i) => {
+			switch (item.type) {
+				case "BOOL":
+					html+=`<input type="checkbox" name="${gr.id}:${item.id}" ${item.val?"checked":''}>${item.label}<br>`;
+					break;
+				case "NUM":
+					html+=`<span class="label-inline">${item.label}</span><input type="number" name="${gr.id}:${item.id}" min=${item.min} max=${item.max} value=${item.val} style="width:150px"><br>`;
+					break;
+				case "ONEOF":
+					html+=`<span class="label-inline">${item.label}</span><select name="${gr.id}:${item.id}" style="width:160px">`;
+					item.options.forEach((txt, i) => { html+=` <option value=${i} ${item.val==i?"selected":''}>${txt}</option>`;});
+					html+=`</select><br>`;
+					break;
+				case "TIME":
+					let time = String(item.hh).padStart(2,'0')+":"+String(item.mm).padStart(2,'0');
+					html+=`<span class="label-inline">${item.label}</span><input type="time" name="${gr.id}:${item.id}" min="00:00" max="23:59" value="${time}" style="width:150px"/><br>`;
+					break;
+				case "COLOR":
+					html+=`<span class="label-inline">${item.label}</span><input type="color" name="${gr.id}:${item.id}" value="${item.val}" style="width:50px"/><br>`;
+					break;
+				default:
+					break;
+			}
 		});
-		html+=`<input type="submit" value="submit"></form>`;
-		html+=`<button onclick='reset()'>RESTART</button>`;
+		html+=`</small>`;
+	});
+	html+=`<input type="submit" value="submit"></form>`;
+	html+=`<button onclick='reset()'>RESTART</button>`;
 
-		div.innerHTML = html;
-		const form = document.getElementById('brd-form');
-		form.onsubmit = function(e){
-			e.preventDefault();
-			let data = decodeURIComponent(new URLSearchParams(new FormData(this)));
-			fetch(esp_url+"/settings?action=set",
-			{
-				method: "POST",
-				body: data
-			})
-			.then(r => r.json())
-			.then(js => { alert("board config changed"); });
-		};
-	})
+	div.innerHTML = html;
+	const form = document.getElementById('brd-form');
+	form.onsubmit = function(e){
+		e.preventDefault();
+		let data = decodeURIComponent(new URLSearchParams(new FormData(this)));
+		fetch(esp_url+"/settings?action=set",
+		{
+			method: "POST",
+			body: data
+		})
+		.then(r => r.json())
+		.then(js => { alert("board config changed"); });
+	};
 }
 
-function appInfo(){
-	fetch(esp_url+"/info")
-	.then(r => r.json())
-	.then(js => {
-		const div = document.getElementById('app');
+function showAppInfo(info){
+	const div = document.getElementById('app');
+
+	let html = `
+		<h6>Firmware:</h6>
+		<small>project: ${info.project_name}</small><br>
+		<small>version: ${info.version}</small><br>
+		<small>idf_ver: ${info.idf_ver}</small><br>
+		<small>bulid date: ${info.date}</small><br>
+		<small>bulid time: ${info.time}</small><br>`;
 
-		let info = `
-			<h6>Firmware:</h6>
-			<small>project: ${js.project_name}</small><br>
-			<small>version: ${js.version}</small><br>
-			<small>idf_ver: ${js.idf_ver}</small><br>
-			<small>bulid date: ${js.date}</small><br>
-			<small>bulid time: ${js.time}</small><br>`;
+	div.innerHTML = html;
+}
 
-		div.innerHTML = info;
+// network, firmware and board settings come in one request
+function loadStatus(){
+	fetch(esp_url+"/status")
+	.then(r => r.json())
+	.then(js => {
+		showNetStats(js.wifi.sta);
+		showWiFiConfigForm(js.wifi.sta);
+		showAppInfo(js.info);
+		showSettingsForm(js.settings);
 	});
 }
 
+function otaProgress(js){
+	if(js.size)
+		loadbar.innerHTML = `Please wait... ${Math.floor(100*js.bytes/js.size)}% (${(js.bytes_per_sec/1024).toFixed(1)} kB/s)`;
+}
+
 function uploadFile(event){
 	event.preventDefault();
 	var xhttp = new XMLHttpRequest();
-	var data = new FormData(event.target);
+	var file = event.target.firmware.files[0];
+
+	if(!file)
+		return;
 
 	xhttp.onload = function() {
 		if(this.status == 200){
 			var js = JSON.parse(this.responseText);
-			alert((js.result==='ESP_OK')?('Update success:\n\n'+js.bytes_uploaded +'b uploaded'):('Update error'));
+			alert((js.result==='ESP_OK')?('Update success:\n\n'+js.bytes_uploaded +'b uploaded at '+(js.bytes_per_sec/1024).toFixed(1)+' kB/s\nsha256: '+js.sha256+'\n\nrestarting...'):('Update error: '+js.result));
 		} else {
 			alert('Request Error');
 		}
@@ -231,9 +313,12 @@ function uploadFile(event){
 		loadbar.style.display = 'none';
 	};
 
+	// raw image, device hashes and writes it while receiving
 	xhttp.timeout = 120000;
 	xhttp.open("POST",event.target.action, true);
+	xhttp.setRequestHeader('Content-Type', 'application/octet-stream');
+	loadbar.innerHTML = 'Please wait...';
 	loadbar.style.display = 'block';
 	event.target.style.display = 'none';
-	xhttp.send(data);
+	xhttp.send(file);
 }
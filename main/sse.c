@@ -0,0 +1,230 @@
+/*
+ * Copyright (c) 2025 <qb4.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "sse.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <esp_wifi.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <device.h>
+
+#define SSE_CLIENTS_MAX 2
+#define SSE_CHANNEL_EVENTS_MAX 8
+#define SSE_CHECK_INTERVAL_US (1000 * 1000)
+#define SSE_KEEPALIVE_US (15 * 1000 * 1000)
+#define SSE_RSSI_DEADBAND 3
+
+static const char *TAG = "SSE";
+
+static const char *sse_header = "HTTP/1.1 200 OK\r\n"
+                                "Content-Type: text/event-stream\r\n"
+                                "Cache-Control: no-cache\r\n"
+                                "Connection: keep-alive\r\n\r\n";
+
+struct sse_channel_event {
+    int32_t                id;
+    device_channel_event_t ev;
+};
+
+static struct {
+    supla_dev_state_t state;
+    int8_t            rssi;
+    int64_t           sent_at;
+} last_status;
+
+static httpd_handle_t     sse_server;
+static supla_dev_t       *sse_dev;
+static esp_timer_handle_t sse_timer;
+static QueueHandle_t      channel_events;
+static int                clients[SSE_CLIENTS_MAX];
+static int                clients_num;
+
+// called by httpd when subscriber session is closed, before its socket can be reused
+static void sse_client_free(void *ctx)
+{
+    int fd = *(int *)ctx;
+
+    for (int i = 0; i < clients_num; i++) {
+        if (clients[i] == fd) {
+            ESP_LOGD(TAG, "client %d closed", fd);
+            clients[i] = clients[--clients_num];
+            break;
+        }
+    }
+    free(ctx);
+}
+
+static void sse_send_all(const char *msg, int len)
+{
+    for (int i = 0; i < clients_num; i++) {
+        // client gone, browser reconnects on its own if page is still open
+        if (httpd_socket_send(sse_server, clients[i], msg, len, 0) != len)
+            httpd_sess_trigger_close(sse_server, clients[i]);
+    }
+}
+
+static int sse_status_format(char *buf, size_t size, supla_dev_state_t state, int8_t rssi)
+{
+    return snprintf(buf, size,
+                    "event: status\ndata: {\"state\":\"%s\",\"uptime\":%" PRIu32
+                    ",\"rssi\":%d}\n\n",
+                    supla_dev_state_str(state), (uint32_t)(esp_timer_get_time() / 1000000),
+                    rssi);
+}
+
+static void sse_status_get(supla_dev_state_t *state, int8_t *rssi)
+{
+    wifi_ap_record_t ap_info;
+
+    *state = SUPLA_DEV_STATE_IDLE;
+    *rssi = 0;
+    if (sse_dev)
+        supla_dev_get_state(sse_dev, state);
+    if (esp_wifi_sta_get_ap_info(&ap_info) == ESP_OK)
+        *rssi = ap_info.rssi;
+}
+
+// runs in httpd task, so socket list is never touched concurrently
+static void sse_work(void *arg)
+{
+    static const char       *event_names[] = { [DEVICE_EVENT_VALUE_CHANGED] = "value",
+                                               [DEVICE_EVENT_INPUT] = "input",
+                                               [DEVICE_EVENT_FAULT] = "fault" };
+    struct sse_channel_event item;
+    supla_dev_state_t        state;
+    int8_t                   rssi;
+    int64_t                  now = esp_timer_get_time();
+    char                     msg[128];
+    int                      len;
+
+    while (xQueueReceive(channel_events, &item, 0) == pdTRUE) {
+        if (!clients_num)
+            continue;
+        len = snprintf(msg, sizeof(msg),
+                       "event: channel\ndata: {\"number\":%d,\"event\":\"%s\",\"code\":%" PRIi32
+                       "}\n\n",
+                       supla_channel_get_assigned_number(item.ev.channel), event_names[item.id],
+                       item.ev.code);
+        sse_send_all(msg, len);
+    }
+    if (!clients_num)
+        return;
+
+    sse_status_get(&state, &rssi);
+    if (state != last_status.state || abs(rssi - last_status.rssi) >= SSE_RSSI_DEADBAND ||
+        now - last_status.sent_at >= SSE_KEEPALIVE_US) {
+        len = sse_status_format(msg, sizeof(msg), state, rssi);
+        sse_send_all(msg, len);
+        last_status.state = state;
+        last_status.rssi = rssi;
+        last_status.sent_at = now;
+    }
+}
+
+static void sse_timer_cb(void *arg)
+{
+    if (sse_server && clients_num)
+        httpd_queue_work(sse_server, sse_work, NULL);
+}
+
+static void sse_channel_event_handler(void *arg, esp_event_base_t base, int32_t id, void *data)
+{
+    struct sse_channel_event item = { .id = id, .ev = *(device_channel_event_t *)data };
+
+    if (!sse_server || !clients_num)
+        return;
+    // push right away instead of waiting for next status check
+    if (xQueueSend(channel_events, &item, 0) == pdTRUE)
+        httpd_queue_work(sse_server, sse_work, NULL);
+}
+
+esp_err_t sse_start(httpd_handle_t server, supla_dev_t *dev)
+{
+    esp_timer_create_args_t timer_args = {
+        .name = "sse",
+        .dispatch_method = ESP_TIMER_TASK,
+        .callback = sse_timer_cb,
+    };
+
+    if (!channel_events) {
+        channel_events = xQueueCreate(SSE_CHANNEL_EVENTS_MAX, sizeof(struct sse_channel_event));
+        if (!channel_events)
+            return ESP_ERR_NO_MEM;
+        device_event_register(DEVICE_EVENT_VALUE_CHANGED, sse_channel_event_handler, NULL);
+        device_event_register(DEVICE_EVENT_INPUT, sse_channel_event_handler, NULL);
+        device_event_register(DEVICE_EVENT_FAULT, sse_channel_event_handler, NULL);
+        esp_timer_create(&timer_args, &sse_timer);
+    }
+    xQueueReset(channel_events);
+    sse_server = server;
+    sse_dev = dev;
+    clients_num = 0;
+    return esp_timer_start_periodic(sse_timer, SSE_CHECK_INTERVAL_US);
+}
+
+esp_err_t sse_stop(void)
+{
+    if (!sse_server)
+        return ESP_ERR_INVALID_STATE;
+
+    esp_timer_stop(sse_timer);
+    sse_server = NULL;
+    clients_num = 0; // sockets are closed with server
+    return ESP_OK;
+}
+
+void sse_send_event(const char *event, const char *data)
+{
+    char msg[256];
+    int  len;
+
+    if (!sse_server || !clients_num)
+        return;
+    len = snprintf(msg, sizeof(msg), "event: %s\ndata: %s\n\n", event, data);
+    if (len > 0 && len < sizeof(msg))
+        sse_send_all(msg, len);
+}
+
+esp_err_t sse_httpd_handler(httpd_req_t *req)
+{
+    supla_dev_state_t state;
+    int8_t            rssi;
+    char              msg[128];
+    int               len;
+    int              *fd;
+
+    if (clients_num >= SSE_CLIENTS_MAX) {
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        return httpd_resp_send(req, NULL, 0);
+    }
+
+    // response is never finished, socket stays open for pushed events
+    if (httpd_send(req, sse_header, strlen(sse_header)) < 0)
+        return ESP_FAIL;
+
+    sse_status_get(&state, &rssi);
+    len = sse_status_format(msg, sizeof(msg), state, rssi);
+    if (httpd_send(req, msg, len) != len)
+        return ESP_FAIL;
+    last_status.state = state;
+    last_status.rssi = rssi;
+    last_status.sent_at = esp_timer_get_time();
+
+    fd = malloc(sizeof(int));
+    if (!fd)
+        return ESP_ERR_NO_MEM;
+    *fd = httpd_req_to_sockfd(req);
+    req->sess_ctx = fd;
+    req->free_ctx = sse_client_free;
+    clients[clients_num++] = *fd;
+    ESP_LOGI(TAG, "client %d subscribed", *fd);
+    return ESP_OK;
+}
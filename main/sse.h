@@ -0,0 +1,35 @@
+/*
+ * Copyright (c) 2025 <qb4.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#ifndef MAIN_SSE_H_
+#define MAIN_SSE_H_
+
+#include <esp_http_server.h>
+#include <esp-supla.h>
+
+/**
+ * @brief Start pushing status and channel events to /events subscribers
+ *
+ * Status (SUPLA state, uptime, RSSI) is sent on change and as a keep-alive,
+ * channel events are pushed as soon as they are published on device event bus.
+ */
+esp_err_t sse_start(httpd_handle_t server, supla_dev_t *dev);
+esp_err_t sse_stop(void);
+
+/**
+ * @brief Push custom event to all subscribers
+ *
+ * Must be called from httpd task, i.e. from URI handler or queued work.
+ */
+void sse_send_event(const char *event, const char *data);
+
+/**
+ * @brief Subscribe to Server-Sent Events stream
+ *
+ */
+esp_err_t sse_httpd_handler(httpd_req_t *req);
+
+#endif /* MAIN_SSE_H_ */
@@ -0,0 +1,259 @@
+/*
+ * Copyright (c) 2025 <qb4.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "stats.h"
+#include "wifi.h"
+#include "sysmon.h"
+#include <device.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cJSON.h>
+#include <esp_timer.h>
+#include <esp_log.h>
+#include <inttypes.h>
+
+static const char *TAG = "STATS";
+
+static const char *boot_phase_names[BOOT_PHASE_MAX] = {
+    [BOOT_PHASE_APP_MAIN] = "app_main",
+    [BOOT_PHASE_NVS_INIT] = "nvs_init",
+    [BOOT_PHASE_BOARD_EARLY_INIT] = "board_early_init",
+    [BOOT_PHASE_DEVICE_INIT] = "device_init",
+    [BOOT_PHASE_SUPLA_INIT] = "supla_device_init",
+    [BOOT_PHASE_BOARD_SUPLA_INIT] = "board_supla_init",
+    [BOOT_PHASE_WIFI_INIT] = "wifi_init",
+    [BOOT_PHASE_WIFI_GOT_IP] = "wifi_got_ip",
+    [BOOT_PHASE_SUPLA_CONNECTED] = "supla_connected",
+    [BOOT_PHASE_SUPLA_REGISTERED] = "supla_registered",
+    [BOOT_PHASE_SUPLA_ONLINE] = "supla_online"
+};
+
+static const char *sleep_mode_names[DEVICE_SLEEP_MODE_MAX] = {
+    [DEVICE_SLEEP_MODE_NONE] = "active",
+    [DEVICE_SLEEP_MODE_MODEM] = "modem",
+    [DEVICE_SLEEP_MODE_LIGHT] = "light",
+    [DEVICE_SLEEP_MODE_DEEP] = "deep"
+};
+
+static const char *event_prio_names[DEVICE_EVENT_PRIO_MAX] = {
+    [DEVICE_EVENT_PRIO_NORMAL] = "normal",
+    [DEVICE_EVENT_PRIO_HIGH] = "high"
+};
+
+static const char *pm_lock_names[DEVICE_PM_LOCK_TYPE_MAX] = {
+    [DEVICE_PM_CPU_FREQ_MAX] = "cpu_freq_max",
+    [DEVICE_PM_APB_FREQ_MAX] = "apb_freq_max",
+    [DEVICE_PM_NO_LIGHT_SLEEP] = "no_light_sleep"
+};
+
+static int64_t boot_phase_time[BOOT_PHASE_MAX];
+
+static struct {
+    uint32_t iterations;
+    uint32_t wakeups;
+    uint32_t latency_last_us;
+    uint32_t latency_max_us;
+    uint64_t latency_sum_us;
+} loop_stats;
+
+void stats_boot_mark(boot_phase_t phase)
+{
+    if (phase >= BOOT_PHASE_MAX || boot_phase_time[phase])
+        return;
+
+    boot_phase_time[phase] = esp_timer_get_time();
+}
+
+void stats_loop_record(bool notified, int64_t latency_us)
+{
+    loop_stats.iterations++;
+    if (!notified)
+        return;
+
+    loop_stats.wakeups++;
+    loop_stats.latency_last_us = latency_us;
+    loop_stats.latency_sum_us += latency_us;
+    if (latency_us > loop_stats.latency_max_us)
+        loop_stats.latency_max_us = latency_us;
+}
+
+static cJSON *loop_stats_to_json(void)
+{
+    cJSON *js = cJSON_CreateObject();
+
+    cJSON_AddNumberToObject(js, "iterations", loop_stats.iterations);
+    cJSON_AddNumberToObject(js, "wakeups", loop_stats.wakeups);
+    cJSON_AddNumberToObject(js, "latency_last_us", loop_stats.latency_last_us);
+    cJSON_AddNumberToObject(js, "latency_max_us", loop_stats.latency_max_us);
+    cJSON_AddNumberToObject(js, "latency_avg_us",
+                            loop_stats.wakeups ? loop_stats.latency_sum_us / loop_stats.wakeups :
+                                                 0);
+    return js;
+}
+
+// some phases run in parallel, so pick the earliest one reached after given time
+static int boot_phase_next(int64_t after)
+{
+    int next = -1;
+
+    for (int i = 0; i < BOOT_PHASE_MAX; i++) {
+        if (boot_phase_time[i] <= after)
+            continue;
+        if (next < 0 || boot_phase_time[i] < boot_phase_time[next])
+            next = i;
+    }
+    return next;
+}
+
+void stats_boot_log(void)
+{
+    int64_t prev = 0;
+
+    for (int next = boot_phase_next(prev); next >= 0; next = boot_phase_next(prev)) {
+        ESP_LOGI(TAG, "%-18s at %6" PRIu32 "ms (+%" PRIu32 "ms)", boot_phase_names[next],
+                 (uint32_t)(boot_phase_time[next] / 1000),
+                 (uint32_t)((boot_phase_time[next] - prev) / 1000));
+        prev = boot_phase_time[next];
+    }
+}
+
+static cJSON *boot_stats_to_json(void)
+{
+    cJSON  *js = cJSON_CreateObject();
+    cJSON  *phases = cJSON_CreateArray();
+    int64_t prev = 0;
+
+    // phases are listed in order they were reached, time in microseconds since boot
+    for (int next = boot_phase_next(prev); next >= 0; next = boot_phase_next(prev)) {
+        cJSON *phase = cJSON_CreateObject();
+
+        cJSON_AddStringToObject(phase, "name", boot_phase_names[next]);
+        cJSON_AddNumberToObject(phase, "at_us", boot_phase_time[next]);
+        cJSON_AddNumberToObject(phase, "duration_us", boot_phase_time[next] - prev);
+        cJSON_AddItemToArray(phases, phase);
+        prev = boot_phase_time[next];
+    }
+    cJSON_AddItemToObject(js, "phases", phases);
+    cJSON_AddNumberToObject(js, "time_to_online_us", boot_phase_time[BOOT_PHASE_SUPLA_ONLINE]);
+    return js;
+}
+
+static cJSON *sleep_stats_to_json(void)
+{
+    cJSON                *js = cJSON_CreateObject();
+    device_sleep_report_t report;
+
+    if (device_sleep_get_report(&report) != ESP_OK)
+        return js;
+
+    for (int i = 0; i < DEVICE_SLEEP_MODE_MAX; i++) {
+        cJSON *mode = cJSON_CreateObject();
+
+        cJSON_AddNumberToObject(mode, "time_ms", report.time_ms[i]);
+        cJSON_AddNumberToObject(mode, "charge_mah", report.charge_mah[i]);
+        cJSON_AddItemToObject(js, sleep_mode_names[i], mode);
+    }
+    cJSON_AddNumberToObject(js, "deep_sleep_cycles", report.deep_sleep_cycles);
+    return js;
+}
+
+static cJSON *pm_stats_to_json(void)
+{
+    cJSON             *js = cJSON_CreateObject();
+    cJSON             *locks = cJSON_CreateObject();
+    device_pm_report_t report;
+
+    cJSON_AddItemToObject(js, "lock_time_ms", locks);
+    if (device_pm_get_report(&report) != ESP_OK)
+        return js;
+
+    for (int i = 0; i < DEVICE_PM_LOCK_TYPE_MAX; i++)
+        cJSON_AddNumberToObject(locks, pm_lock_names[i], report.lock_time_ms[i]);
+    cJSON_AddNumberToObject(js, "uptime_ms", report.uptime_ms);
+    cJSON_AddNumberToObject(js, "max_freq_mhz", report.max_freq_mhz);
+    cJSON_AddNumberToObject(js, "min_freq_mhz", report.min_freq_mhz);
+    cJSON_AddNumberToObject(js, "avg_freq_mhz", report.avg_freq_mhz);
+    return js;
+}
+
+static cJSON *event_stats_to_json(void)
+{
+    cJSON               *js = cJSON_CreateObject();
+    device_event_stats_t st;
+
+    if (device_event_get_stats(&st) != ESP_OK)
+        return js;
+
+    for (int i = 0; i < DEVICE_EVENT_PRIO_MAX; i++) {
+        cJSON *prio = cJSON_CreateObject();
+        cJSON *hist = cJSON_CreateArray();
+
+        cJSON_AddNumberToObject(prio, "posted", st.posted[i]);
+        cJSON_AddNumberToObject(prio, "dropped", st.dropped[i]);
+        cJSON_AddNumberToObject(prio, "pending", st.pending[i]);
+        cJSON_AddNumberToObject(prio, "latency_max_us", st.latency_max_us[i]);
+        for (int b = 0; b < DEVICE_EVENT_LATENCY_BUCKETS; b++)
+            cJSON_AddItemToArray(hist, cJSON_CreateNumber(st.latency_hist[i][b]));
+        cJSON_AddItemToObject(prio, "latency_hist", hist);
+        cJSON_AddItemToObject(js, event_prio_names[i], prio);
+    }
+    return js;
+}
+
+static cJSON *wifi_stats_to_json(void)
+{
+    cJSON                      *js = cJSON_CreateObject();
+    struct wifi_reconnect_stats st;
+
+    wifi_get_reconnect_stats(&st);
+    cJSON_AddNumberToObject(js, "disconnects", st.disconnects);
+    cJSON_AddNumberToObject(js, "reconnect_attempts", st.attempts);
+    cJSON_AddNumberToObject(js, "last_reason", st.last_reason);
+    cJSON_AddNumberToObject(js, "next_delay_ms", st.next_delay_ms);
+    cJSON_AddNumberToObject(js, "reconnects", st.reconnects);
+    cJSON_AddNumberToObject(js, "reconnect_last_ms", st.last_reconnect_ms);
+    cJSON_AddNumberToObject(js, "reconnect_max_ms", st.max_reconnect_ms);
+    cJSON_AddNumberToObject(js, "reconnect_avg_ms",
+                            st.reconnects ? st.total_reconnect_ms / st.reconnects : 0);
+    cJSON_AddNumberToObject(js, "fast_connects", st.fast_connects);
+    cJSON_AddNumberToObject(js, "fast_fallbacks", st.fast_fallbacks);
+    return js;
+}
+
+esp_err_t stats_httpd_info_handler(httpd_req_t *req)
+{
+    const esp_app_desc_t *app_desc = app_get_description();
+    cJSON                *js;
+    char                 *js_txt;
+    esp_err_t             rc;
+
+    js = cJSON_CreateObject();
+    if (!js)
+        return httpd_resp_send_500(req);
+
+    cJSON_AddStringToObject(js, "project_name", app_desc->project_name);
+    cJSON_AddStringToObject(js, "version", app_desc->version);
+    cJSON_AddStringToObject(js, "idf_ver", app_desc->idf_ver);
+    cJSON_AddStringToObject(js, "date", app_desc->date);
+    cJSON_AddStringToObject(js, "time", app_desc->time);
+    cJSON_AddItemToObject(js, "boot", boot_stats_to_json());
+    cJSON_AddItemToObject(js, "loop", loop_stats_to_json());
+    cJSON_AddItemToObject(js, "sleep", sleep_stats_to_json());
+    cJSON_AddItemToObject(js, "pm", pm_stats_to_json());
+    cJSON_AddItemToObject(js, "events", event_stats_to_json());
+    cJSON_AddItemToObject(js, "system", sysmon_to_json());
+    cJSON_AddItemToObject(js, "wifi", wifi_stats_to_json());
+
+    js_txt = cJSON_PrintUnformatted(js);
+    cJSON_Delete(js);
+    if (!js_txt)
+        return httpd_resp_send_500(req);
+
+    httpd_resp_set_type(req, HTTPD_TYPE_JSON);
+    rc = httpd_resp_send(req, js_txt, strlen(js_txt));
+    free(js_txt);
+    return rc;
+}
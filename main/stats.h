@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2025 <qb4.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#ifndef MAIN_STATS_H_
+#define MAIN_STATS_H_
+
+#include <stdbool.h>
+#include <esp_err.h>
+#include <esp_http_server.h>
+
+#ifdef CONFIG_IDF_TARGET_ESP8266
+#include <esp_ota_ops.h>
+#define app_get_description esp_ota_get_app_description
+#else
+#include <esp_idf_version.h>
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+#include <esp_app_desc.h>
+#define app_get_description esp_app_get_description
+#else
+#include <esp_ota_ops.h>
+#define app_get_description esp_ota_get_app_description
+#endif
+#endif
+
+typedef enum {
+    BOOT_PHASE_APP_MAIN = 0,
+    BOOT_PHASE_NVS_INIT,
+    BOOT_PHASE_BOARD_EARLY_INIT,
+    BOOT_PHASE_DEVICE_INIT,
+    BOOT_PHASE_SUPLA_INIT,
+    BOOT_PHASE_BOARD_SUPLA_INIT,
+    BOOT_PHASE_WIFI_INIT,
+    BOOT_PHASE_WIFI_GOT_IP,
+    BOOT_PHASE_SUPLA_CONNECTED,
+    BOOT_PHASE_SUPLA_REGISTERED,
+    BOOT_PHASE_SUPLA_ONLINE,
+    BOOT_PHASE_MAX
+} boot_phase_t;
+
+/**
+ * @brief Mark end of boot phase
+ *
+ * Stores time since boot of the first occurrence of each phase,
+ * later calls for the same phase (e.g. after reconnect) are ignored.
+ */
+void stats_boot_mark(boot_phase_t phase);
+
+/**
+ * @brief Print boot phases timing to log
+ *
+ */
+void stats_boot_log(void);
+
+void stats_loop_record(bool notified, int64_t latency_us);
+
+esp_err_t stats_httpd_info_handler(httpd_req_t *req);
+
+#endif /* MAIN_STATS_H_ */
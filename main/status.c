@@ -0,0 +1,266 @@
+/*
+ * Copyright (c) 2025 <qb4.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "status.h"
+#include "stats.h"
+#include "wifi.h"
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+#include <esp_wifi.h>
+
+#define STATUS_CHUNK_SIZE 512
+
+struct json_writer {
+    httpd_req_t *req;
+    size_t       len;
+    bool         comma; // next value needs separator
+    esp_err_t    rc;
+};
+
+// httpd handles one request at a time, so single buffer is enough
+static char status_buf[STATUS_CHUNK_SIZE];
+
+static void jw_flush(struct json_writer *w)
+{
+    if (w->len && w->rc == ESP_OK)
+        w->rc = httpd_resp_send_chunk(w->req, status_buf, w->len);
+    w->len = 0;
+}
+
+static void jw_write(struct json_writer *w, const char *s, size_t n)
+{
+    while (n && w->rc == ESP_OK) {
+        size_t part = sizeof(status_buf) - w->len;
+
+        if (part > n)
+            part = n;
+        memcpy(status_buf + w->len, s, part);
+        w->len += part;
+        s += part;
+        n -= part;
+        if (w->len == sizeof(status_buf))
+            jw_flush(w);
+    }
+}
+
+static void jw_puts(struct json_writer *w, const char *s)
+{
+    jw_write(w, s, strlen(s));
+}
+
+static void jw_quoted(struct json_writer *w, const char *s)
+{
+    char esc[8];
+
+    jw_puts(w, "\"");
+    for (; s && *s; s++) {
+        if (*s == '"' || *s == '\\') {
+            esc[0] = '\\';
+            esc[1] = *s;
+            jw_write(w, esc, 2);
+        } else if ((unsigned char)*s < 0x20) {
+            jw_write(w, esc, snprintf(esc, sizeof(esc), "\\u%04x", *s));
+        } else {
+            jw_write(w, s, 1);
+        }
+    }
+    jw_puts(w, "\"");
+}
+
+// writes separator and key when value is an object member
+static void jw_key(struct json_writer *w, const char *key)
+{
+    if (w->comma)
+        jw_puts(w, ",");
+    if (key) {
+        jw_quoted(w, key);
+        jw_puts(w, ":");
+    }
+    w->comma = true;
+}
+
+static void jw_begin(struct json_writer *w, const char *key, const char *bracket)
+{
+    jw_key(w, key);
+    jw_puts(w, bracket);
+    w->comma = false;
+}
+
+static void jw_end(struct json_writer *w, const char *bracket)
+{
+    jw_puts(w, bracket);
+    w->comma = true;
+}
+
+static void jw_str(struct json_writer *w, const char *key, const char *val)
+{
+    jw_key(w, key);
+    jw_quoted(w, val);
+}
+
+static void jw_int(struct json_writer *w, const char *key, int32_t val)
+{
+    char num[12];
+
+    jw_key(w, key);
+    jw_write(w, num, snprintf(num, sizeof(num), "%" PRIi32, val));
+}
+
+static void jw_bool(struct json_writer *w, const char *key, bool val)
+{
+    jw_key(w, key);
+    jw_puts(w, val ? "true" : "false");
+}
+
+static void jw_ip(struct json_writer *w, const char *key, uint32_t addr)
+{
+    char ip[16];
+
+    // lwip keeps addresses in network byte order
+    snprintf(ip, sizeof(ip), "%u.%u.%u.%u", (unsigned)(addr & 0xff), (unsigned)(addr >> 8 & 0xff),
+             (unsigned)(addr >> 16 & 0xff), (unsigned)(addr >> 24));
+    jw_str(w, key, ip);
+}
+
+static void status_supla(struct json_writer *w, supla_dev_t *dev)
+{
+    supla_dev_state_t state = SUPLA_DEV_STATE_IDLE;
+
+    if (dev)
+        supla_dev_get_state(dev, &state);
+
+    jw_begin(w, "supla", "{");
+    jw_str(w, "state", supla_dev_state_str(state));
+    jw_int(w, "uptime", esp_timer_get_time() / 1000000);
+    jw_end(w, "}");
+}
+
+static void status_wifi(struct json_writer *w)
+{
+    wifi_config_t       wifi_config;
+    wifi_ap_record_t    ap_info;
+    struct wifi_ip_info ip_info = {};
+    bool                connected = esp_wifi_sta_get_ap_info(&ap_info) == ESP_OK;
+
+    jw_begin(w, "wifi", "{");
+    jw_begin(w, "sta", "{");
+    if (esp_wifi_get_config(ESP_IF_WIFI_STA, &wifi_config) == ESP_OK)
+        jw_str(w, "ssid", (const char *)wifi_config.sta.ssid);
+    jw_str(w, "status", connected ? "CONNECTED" : "DISCONNECTED");
+    if (connected) {
+        jw_begin(w, "connection", "{");
+        jw_str(w, "ssid", (const char *)ap_info.ssid);
+        jw_int(w, "authmode", ap_info.authmode);
+        jw_int(w, "rssi", ap_info.rssi);
+        jw_end(w, "}");
+    }
+    wifi_get_sta_ip_info(&ip_info);
+    jw_begin(w, "ip_info", "{");
+    jw_ip(w, "ip", ip_info.ip);
+    jw_ip(w, "netmask", ip_info.netmask);
+    jw_ip(w, "gw", ip_info.gw);
+    jw_end(w, "}");
+    jw_end(w, "}");
+    jw_end(w, "}");
+}
+
+static void status_info(struct json_writer *w)
+{
+    const esp_app_desc_t *app_desc = app_get_description();
+
+    jw_begin(w, "info", "{");
+    jw_str(w, "project_name", app_desc->project_name);
+    jw_str(w, "version", app_desc->version);
+    jw_str(w, "idf_ver", app_desc->idf_ver);
+    jw_str(w, "date", app_desc->date);
+    jw_str(w, "time", app_desc->time);
+    jw_int(w, "free_heap", esp_get_free_heap_size());
+    jw_end(w, "}");
+}
+
+static void status_setting(struct json_writer *w, const setting_t *set)
+{
+    char color[8];
+
+    jw_begin(w, NULL, "{");
+    jw_str(w, "id", set->id);
+    jw_str(w, "label", set->label);
+    switch (set->type) {
+    case SETTING_TYPE_BOOL:
+        jw_str(w, "type", "BOOL");
+        jw_bool(w, "val", set->boolean.val);
+        break;
+    case SETTING_TYPE_NUM:
+        jw_str(w, "type", "NUM");
+        jw_int(w, "val", set->num.val);
+        jw_int(w, "min", set->num.range.min);
+        jw_int(w, "max", set->num.range.max);
+        break;
+    case SETTING_TYPE_ONEOF:
+        jw_str(w, "type", "ONEOF");
+        jw_int(w, "val", set->oneof.val);
+        jw_begin(w, "options", "[");
+        for (const char **label = set->oneof.labels; label && *label; label++)
+            jw_str(w, NULL, *label);
+        jw_end(w, "]");
+        break;
+    case SETTING_TYPE_TIME:
+        jw_str(w, "type", "TIME");
+        jw_int(w, "hh", set->time.hh);
+        jw_int(w, "mm", set->time.mm);
+        break;
+    case SETTING_TYPE_COLOR:
+        snprintf(color, sizeof(color), "#%02x%02x%02x", set->color.r, set->color.g,
+                 set->color.b);
+        jw_str(w, "type", "COLOR");
+        jw_str(w, "val", color);
+        break;
+    default:
+        break;
+    }
+    jw_end(w, "}");
+}
+
+static void status_settings(struct json_writer *w, const settings_group_t *settings_pack)
+{
+    jw_begin(w, "settings", "{");
+    jw_begin(w, "groups", "[");
+    for (const settings_group_t *gr = settings_pack; gr && gr->id; gr++) {
+        jw_begin(w, NULL, "{");
+        jw_str(w, "id", gr->id);
+        jw_str(w, "label", gr->label);
+        jw_begin(w, "settings", "[");
+        for (const setting_t *set = gr->settings; set && set->id; set++)
+            status_setting(w, set);
+        jw_end(w, "]");
+        jw_end(w, "}");
+    }
+    jw_end(w, "]");
+    jw_end(w, "}");
+}
+
+esp_err_t status_httpd_handler(httpd_req_t *req)
+{
+    struct status_ctx *ctx = req->user_ctx;
+    struct json_writer w = { .req = req, .rc = ESP_OK };
+
+    httpd_resp_set_type(req, HTTPD_TYPE_JSON);
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+
+    jw_begin(&w, NULL, "{");
+    status_supla(&w, ctx->dev ? *ctx->dev : NULL);
+    status_wifi(&w);
+    status_info(&w);
+    status_settings(&w, ctx->settings_pack);
+    jw_end(&w, "}");
+    jw_flush(&w);
+    if (w.rc != ESP_OK)
+        return w.rc;
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
@@ -0,0 +1,27 @@
+/*
+ * Copyright (c) 2025 <qb4.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#ifndef MAIN_STATUS_H_
+#define MAIN_STATUS_H_
+
+#include <esp_http_server.h>
+#include <esp-supla.h>
+#include <settings.h>
+
+struct status_ctx {
+    supla_dev_t           **dev;
+    const settings_group_t *settings_pack;
+};
+
+/**
+ * @brief Write SUPLA, WiFi, firmware and board settings state as one JSON
+ *
+ * Response is streamed with chunked encoding from a static buffer, no heap is
+ * used. Handler context must point to struct status_ctx.
+ */
+esp_err_t status_httpd_handler(httpd_req_t *req);
+
+#endif /* MAIN_STATUS_H_ */
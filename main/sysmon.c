@@ -0,0 +1,211 @@
+/*
+ * Copyright (c) 2025 <qb4.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "sysmon.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <esp_log.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+
+#ifndef CONFIG_IDF_TARGET_ESP8266
+#include <esp_heap_caps.h>
+#endif
+
+#define SYSMON_TASKS_MAX 24
+
+struct task_sample {
+    TaskHandle_t handle;
+    char         name[configMAX_TASK_NAME_LEN];
+    uint32_t     stack_free;   // stack high water mark in bytes
+    uint32_t     run_time;     // run time counter at last sample
+    uint32_t     cpu_permille; // CPU usage over last interval
+    UBaseType_t  priority;
+};
+
+static const char *TAG = "SYSMON";
+
+static esp_timer_handle_t sysmon_timer;
+static SemaphoreHandle_t  sysmon_lock;
+static struct task_sample task_samples[SYSMON_TASKS_MAX];
+static int                task_samples_num;
+static uint32_t           heap_free;
+static uint32_t           heap_min_free;
+#ifndef CONFIG_IDF_TARGET_ESP8266
+static uint32_t heap_largest_block;
+static uint32_t heap_min_largest_block = UINT32_MAX;
+#endif
+
+#if configUSE_TRACE_FACILITY
+static struct task_sample *task_sample_find(TaskHandle_t handle)
+{
+    for (int i = 0; i < task_samples_num; i++) {
+        if (task_samples[i].handle == handle)
+            return &task_samples[i];
+    }
+    return NULL;
+}
+
+static void sysmon_sample_tasks(void)
+{
+    static uint32_t           prev_total_run_time;
+    static struct task_sample samples[SYSMON_TASKS_MAX]; // off esp_timer stack, never re-entered
+    TaskStatus_t             *status;
+    UBaseType_t               num;
+    uint32_t                  total_run_time = 0;
+    uint32_t                  run_time_delta;
+
+    status = malloc(SYSMON_TASKS_MAX * sizeof(TaskStatus_t));
+    if (!status)
+        return;
+
+    num = uxTaskGetSystemState(status, SYSMON_TASKS_MAX, &total_run_time);
+    run_time_delta = total_run_time - prev_total_run_time;
+    prev_total_run_time = total_run_time;
+
+    for (int i = 0; i < num; i++) {
+        struct task_sample *prev = task_sample_find(status[i].xHandle);
+        struct task_sample *s = &samples[i];
+
+        s->handle = status[i].xHandle;
+        snprintf(s->name, sizeof(s->name), "%s", status[i].pcTaskName);
+        s->stack_free = status[i].usStackHighWaterMark * sizeof(StackType_t);
+        s->priority = status[i].uxCurrentPriority;
+        s->run_time = status[i].ulRunTimeCounter;
+        s->cpu_permille = 0;
+        if (prev && run_time_delta)
+            s->cpu_permille = (uint64_t)(s->run_time - prev->run_time) * 1000 / run_time_delta;
+
+        if (s->stack_free < CONFIG_APP_SYSMON_STACK_WARN_BYTES)
+            ESP_LOGW(TAG, "task %s stack low: %" PRIu32 " bytes free", s->name, s->stack_free);
+    }
+    free(status);
+
+    memcpy(task_samples, samples, num * sizeof(struct task_sample));
+    task_samples_num = num;
+}
+#else
+// no task list without trace facility, stacks of known long running tasks are sampled
+static const char *const watch_names[] = { "dev", "pulse", "httpd" };
+static TaskHandle_t      main_task;
+
+static void sysmon_sample_tasks(void)
+{
+    TaskHandle_t handles[2 + sizeof(watch_names) / sizeof(watch_names[0])];
+    int          num = 0;
+
+    handles[num++] = main_task;
+    // esp_timer task, except for first sample made by main task
+    if (xTaskGetCurrentTaskHandle() != main_task)
+        handles[num++] = xTaskGetCurrentTaskHandle();
+
+    // tasks found are not deleted until the scheduler is resumed
+    vTaskSuspendAll();
+#if INCLUDE_xTaskGetHandle
+    for (int i = 0; i < sizeof(watch_names) / sizeof(watch_names[0]); i++) {
+        handles[num] = xTaskGetHandle(watch_names[i]);
+        if (handles[num])
+            num++;
+    }
+#endif
+    for (int i = 0; i < num; i++) {
+        struct task_sample *s = &task_samples[i];
+
+        s->handle = handles[i];
+        snprintf(s->name, sizeof(s->name), "%s", pcTaskGetName(handles[i]));
+        s->stack_free = uxTaskGetStackHighWaterMark(handles[i]) * sizeof(StackType_t);
+        s->priority = uxTaskPriorityGet(handles[i]);
+        s->run_time = 0;
+        s->cpu_permille = 0;
+    }
+    task_samples_num = num;
+    xTaskResumeAll();
+
+    for (int i = 0; i < num; i++) {
+        if (task_samples[i].stack_free < CONFIG_APP_SYSMON_STACK_WARN_BYTES) {
+            ESP_LOGW(TAG, "task %s stack low: %" PRIu32 " bytes free", task_samples[i].name,
+                     task_samples[i].stack_free);
+        }
+    }
+}
+#endif
+
+static void sysmon_sample(void *arg)
+{
+    xSemaphoreTake(sysmon_lock, portMAX_DELAY);
+    heap_free = esp_get_free_heap_size();
+    heap_min_free = esp_get_minimum_free_heap_size();
+#ifndef CONFIG_IDF_TARGET_ESP8266
+    heap_largest_block = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    if (heap_largest_block < heap_min_largest_block)
+        heap_min_largest_block = heap_largest_block;
+#endif
+    sysmon_sample_tasks();
+    xSemaphoreGive(sysmon_lock);
+}
+
+esp_err_t sysmon_init(void)
+{
+    const esp_timer_create_args_t timer_args = {
+        .name = "sysmon",
+        .dispatch_method = ESP_TIMER_TASK,
+        .callback = sysmon_sample,
+    };
+    esp_err_t rc;
+
+    sysmon_lock = xSemaphoreCreateMutex();
+    if (!sysmon_lock)
+        return ESP_ERR_NO_MEM;
+#if !configUSE_TRACE_FACILITY
+    main_task = xTaskGetCurrentTaskHandle();
+#endif
+
+    rc = esp_timer_create(&timer_args, &sysmon_timer);
+    if (rc != ESP_OK)
+        return rc;
+
+    sysmon_sample(NULL);
+    return esp_timer_start_periodic(sysmon_timer, CONFIG_APP_SYSMON_INTERVAL_S * 1000000LL);
+}
+
+cJSON *sysmon_to_json(void)
+{
+    cJSON *js = cJSON_CreateObject();
+    cJSON *heap = cJSON_CreateObject();
+    cJSON *tasks = cJSON_CreateArray();
+
+    if (!sysmon_lock)
+        return js;
+
+    xSemaphoreTake(sysmon_lock, portMAX_DELAY);
+    cJSON_AddNumberToObject(heap, "free", heap_free);
+    cJSON_AddNumberToObject(heap, "min_free", heap_min_free);
+#ifndef CONFIG_IDF_TARGET_ESP8266
+    cJSON_AddNumberToObject(heap, "largest_block", heap_largest_block);
+    cJSON_AddNumberToObject(heap, "min_largest_block", heap_min_largest_block);
+#endif
+    for (int i = 0; i < task_samples_num; i++) {
+        cJSON *task = cJSON_CreateObject();
+
+        cJSON_AddStringToObject(task, "name", task_samples[i].name);
+        cJSON_AddNumberToObject(task, "prio", task_samples[i].priority);
+        cJSON_AddNumberToObject(task, "stack_free", task_samples[i].stack_free);
+#if configGENERATE_RUN_TIME_STATS
+        cJSON_AddNumberToObject(task, "cpu_permille", task_samples[i].cpu_permille);
+#endif
+        cJSON_AddItemToArray(tasks, task);
+    }
+    xSemaphoreGive(sysmon_lock);
+
+    cJSON_AddItemToObject(js, "heap", heap);
+    cJSON_AddItemToObject(js, "tasks", tasks);
+    return js;
+}
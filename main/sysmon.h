@@ -0,0 +1,25 @@
+/*
+ * Copyright (c) 2025 <qb4.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#ifndef MAIN_SYSMON_H_
+#define MAIN_SYSMON_H_
+
+#include <esp_err.h>
+#include <cJSON.h>
+
+/**
+ * @brief Start periodic task stack and heap sampling
+ *
+ */
+esp_err_t sysmon_init(void);
+
+/**
+ * @brief Build JSON object with last sample of heap and task stats
+ *
+ */
+cJSON *sysmon_to_json(void);
+
+#endif /* MAIN_SYSMON_H_ */
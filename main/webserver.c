@@ -5,48 +5,78 @@
  */
 
 #include "webserver.h"
+#include "stats.h"
+#include "sse.h"
+#include "status.h"
+#include "metrics.h"
+#include "ota.h"
+#include "captive.h"
+#include "wifi_scan.h"
+#include "webdata.h"
+#include <string.h>
 #include <esp_log.h>
 #include <esp_system.h>
 #include <esp_http_server.h>
-#include <esp_http_server_fota.h>
 #include <esp_http_server_wifi.h>
 
 static const char *TAG = "HTTPD";
 
 static httpd_handle_t server = NULL;
 
+#define EMBED_CACHE_IMMUTABLE "public, max-age=31536000, immutable"
+
+static esp_err_t embed_send(httpd_req_t *req, const char *ct, const char *etag, const char *hash,
+                            const char *data, size_t size)
+{
+    char buf[48];
+    char ver[24];
+    bool versioned = false;
+
+    // assets requested with matching ?v=<hash> never change under this URL
+    if (httpd_req_get_url_query_str(req, buf, sizeof(buf)) == ESP_OK &&
+        httpd_query_key_value(buf, "v", ver, sizeof(ver)) == ESP_OK)
+        versioned = !strcmp(ver, hash);
+
+    httpd_resp_set_hdr(req, "ETag", etag);
+    httpd_resp_set_hdr(req, "Cache-Control", versioned ? EMBED_CACHE_IMMUTABLE : "no-cache");
+    if (httpd_req_get_hdr_value_str(req, "If-None-Match", buf, sizeof(buf)) == ESP_OK &&
+        strstr(buf, etag)) {
+        httpd_resp_set_status(req, "304 Not Modified");
+        return httpd_resp_send(req, NULL, 0);
+    }
+    httpd_resp_set_type(req, ct);
+    httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+    return httpd_resp_send(req, data, size);
+}
+
 #if CONFIG_IDF_TARGET_ESP8266
-#define DECLARE_EMBED_HANDLER(NAME, URI, CT)                             \
-    extern const char embed_##NAME[] asm("_binary_" #NAME "_start");     \
-    extern const char size_##NAME[] asm("_binary_" #NAME "_size");       \
-    esp_err_t         get_##NAME(httpd_req_t *req)                       \
-    {                                                                    \
-        httpd_resp_set_type(req, CT);                                    \
-        httpd_resp_set_hdr(req, "Content-Encoding", "gzip");             \
-        return httpd_resp_send(req, embed_##NAME, (size_t)&size_##NAME); \
-    }                                                                    \
-    static const httpd_uri_t route_get_##NAME = { .uri = (URI),          \
-                                                  .method = HTTP_GET,    \
+#define DECLARE_EMBED_HANDLER(NAME, URI, CT)                                             \
+    extern const char embed_##NAME[] asm("_binary_" #NAME "_start");                     \
+    extern const char size_##NAME[] asm("_binary_" #NAME "_size");                       \
+    esp_err_t         get_##NAME(httpd_req_t *req)                                       \
+    {                                                                                    \
+        return embed_send(req, CT, "\"" WEBDATA_HASH_##NAME "\"", WEBDATA_HASH_##NAME, \
+                          embed_##NAME, (size_t)&size_##NAME);                           \
+    }                                                                                    \
+    static const httpd_uri_t route_get_##NAME = { .uri = (URI),                          \
+                                                  .method = HTTP_GET,                    \
                                                   .handler = get_##NAME }
 #else
-#define DECLARE_EMBED_HANDLER(NAME, URI, CT)                          \
-    extern const char embed_##NAME[] asm("_binary_" #NAME "_start");  \
-    extern const char end_##NAME[] asm("_binary_" #NAME "_end");      \
-    esp_err_t         get_##NAME(httpd_req_t *req)                    \
-    {                                                                 \
-        size_t size = sizeof(uint8_t) * (end_##NAME - embed_##NAME);  \
-        httpd_resp_set_type(req, CT);                                 \
-        httpd_resp_set_hdr(req, "Content-Encoding", "gzip");          \
-        return httpd_resp_send(req, embed_##NAME, size);              \
-    }                                                                 \
-    static const httpd_uri_t route_get_##NAME = { .uri = (URI),       \
-                                                  .method = HTTP_GET, \
+#define DECLARE_EMBED_HANDLER(NAME, URI, CT)                                             \
+    extern const char embed_##NAME[] asm("_binary_" #NAME "_start");                     \
+    extern const char end_##NAME[] asm("_binary_" #NAME "_end");                         \
+    esp_err_t         get_##NAME(httpd_req_t *req)                                       \
+    {                                                                                    \
+        size_t size = sizeof(uint8_t) * (end_##NAME - embed_##NAME);                     \
+        return embed_send(req, CT, "\"" WEBDATA_HASH_##NAME "\"", WEBDATA_HASH_##NAME, \
+                          embed_##NAME, size);                                           \
+    }                                                                                    \
+    static const httpd_uri_t route_get_##NAME = { .uri = (URI),                          \
+                                                  .method = HTTP_GET,                    \
                                                   .handler = get_##NAME }
 #endif
 
 DECLARE_EMBED_HANDLER(index_html_gz, "/index.html", "text/html");
-DECLARE_EMBED_HANDLER(supla_css_gz, "/supla.css", "text/css");
-DECLARE_EMBED_HANDLER(script_js_gz, "/script.js", "text/javascript");
 
 static const httpd_uri_t route_get_root = {
     .uri = "/",
@@ -79,12 +109,34 @@ static httpd_uri_t supla_post_handler = {
 static httpd_uri_t info_handler = {
     .uri = "/info",
     .method = HTTP_GET,
-    .handler = esp_httpd_app_info_handler //
+    .handler = stats_httpd_info_handler //
+};
+static struct status_ctx status_ctx;
+static httpd_uri_t       status_handler = {
+    .uri = "/status",
+    .method = HTTP_GET,
+    .handler = status_httpd_handler,
+    .user_ctx = &status_ctx //
+};
+static httpd_uri_t events_handler = {
+    .uri = "/events",
+    .method = HTTP_GET,
+    .handler = sse_httpd_handler //
+};
+static httpd_uri_t metrics_handler = {
+    .uri = "/metrics",
+    .method = HTTP_GET,
+    .handler = metrics_httpd_handler //
+};
+static httpd_uri_t wifi_scan_handler = {
+    .uri = "/wifi/scan",
+    .method = HTTP_GET,
+    .handler = wifi_scan_httpd_handler //
 };
 static httpd_uri_t fota_handler = {
     .uri = "/update",
     .method = HTTP_POST,
-    .handler = esp_httpd_fota_handler //
+    .handler = ota_httpd_handler //
 };
 
 static httpd_uri_t settings_get_handler = {
@@ -114,13 +166,12 @@ static esp_err_t init(supla_dev_t **dev, const settings_group_t *settings_pack)
 {
     // Static file handlers
     ESP_ERROR_CHECK(httpd_register_uri_handler(server, &route_get_index_html_gz));
-    ESP_ERROR_CHECK(httpd_register_uri_handler(server, &route_get_script_js_gz));
-    ESP_ERROR_CHECK(httpd_register_uri_handler(server, &route_get_supla_css_gz));
     ESP_ERROR_CHECK(httpd_register_uri_handler(server, &route_get_root));
 
     // Additional handlers
     ESP_ERROR_CHECK(httpd_register_uri_handler(server, &wifi_get_handler));
     ESP_ERROR_CHECK(httpd_register_uri_handler(server, &wifi_post_handler));
+    ESP_ERROR_CHECK(httpd_register_uri_handler(server, &wifi_scan_handler));
 
     supla_get_handler.user_ctx = dev;
     supla_post_handler.user_ctx = dev;
@@ -135,7 +186,13 @@ static esp_err_t init(supla_dev_t **dev, const settings_group_t *settings_pack)
     //    ESP_ERROR_CHECK(httpd_register_uri_handler(server, &basic_post_handler));
 
     ESP_ERROR_CHECK(httpd_register_uri_handler(server, &info_handler));
+    status_ctx.dev = dev;
+    status_ctx.settings_pack = settings_pack;
+    ESP_ERROR_CHECK(httpd_register_uri_handler(server, &status_handler));
+    ESP_ERROR_CHECK(httpd_register_uri_handler(server, &metrics_handler));
+    ESP_ERROR_CHECK(httpd_register_uri_handler(server, &events_handler));
     ESP_ERROR_CHECK(httpd_register_uri_handler(server, &fota_handler));
+    ESP_ERROR_CHECK(captive_httpd_register(server));
 
     if (settings_pack != NULL) {
         settings_get_handler.user_ctx = (void *)settings_pack;
@@ -150,27 +207,61 @@ esp_err_t webserver_start(supla_dev_t **dev, const bsp_t *brd)
 {
     if (server) {
         ESP_LOGI(TAG, "server started, trying to stop...");
+        sse_stop();
         httpd_stop(server);
     }
 
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
-    config.max_uri_handlers = 16;
+    config.max_uri_handlers = 26;
     config.lru_purge_enable = true;
     config.stack_size = 4 * 4096;
 
     ESP_ERROR_CHECK(httpd_start(&server, &config));
     ESP_ERROR_CHECK(init(dev, brd->settings_pack));
+    ESP_ERROR_CHECK(sse_start(server, *dev));
 
     ESP_LOGI(TAG, "server started on port %d, free mem: %" PRIu32 " bytes", config.server_port,
              esp_get_free_heap_size());
     return ESP_OK;
 }
 
+#ifdef CONFIG_APP_STATION_WEBSERVER
+esp_err_t webserver_start_station(void)
+{
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    esp_err_t      rc;
+
+    if (server)
+        return ESP_ERR_INVALID_STATE;
+
+    // nothing here writes config, keep footprint low
+    config.server_port = CONFIG_APP_STATION_WEBSERVER_PORT;
+    config.max_uri_handlers = 2;
+    config.max_open_sockets = 2;
+    config.lru_purge_enable = true;
+    config.stack_size = 4096;
+
+    rc = httpd_start(&server, &config);
+    if (rc != ESP_OK) {
+        ESP_LOGE(TAG, "station server start failed: %s", esp_err_to_name(rc));
+        server = NULL;
+        return rc;
+    }
+    httpd_register_uri_handler(server, &metrics_handler);
+    httpd_register_uri_handler(server, &info_handler);
+
+    ESP_LOGI(TAG, "station server started on port %d, free mem: %" PRIu32 " bytes",
+             config.server_port, esp_get_free_heap_size());
+    return ESP_OK;
+}
+#endif
+
 esp_err_t webserver_stop(void)
 {
     esp_err_t rc;
     if (server) {
         ESP_LOGI(TAG, "server stop...");
+        sse_stop();
         rc = httpd_stop(server);
         server = NULL;
         return rc;
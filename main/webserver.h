@@ -12,6 +12,13 @@
 #include <board.h>
 
 esp_err_t webserver_start(supla_dev_t **dev, const bsp_t *brd);
+
+/**
+ * @brief Start small server with read-only routes for station mode
+ *
+ * Replaced by full server when config mode is entered.
+ */
+esp_err_t webserver_start_station(void);
 esp_err_t webserver_stop(void);
 
 #endif /* MAIN_WEBSERVER_H_ */
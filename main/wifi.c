@@ -11,12 +11,23 @@
 #include <esp_system.h>
 #include <esp_wifi.h>
 #include <esp_netif.h>
+#include <esp_timer.h>
+#include <nvs.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/event_groups.h>
 #include <freertos/task.h>
+#include <device.h>
 
 #include "lwip/err.h"
 #include "lwip/sys.h"
+#include "lwip/dns.h"
+
+#ifdef CONFIG_IDF_TARGET_ESP8266
+#include <tcpip_adapter.h>
+#endif
+
+#define FAST_CONNECT_NVS_NAMESPACE "wifi_fc"
+#define FAST_CONNECT_NVS_KEY "cache"
 
 #define CHECK_ARG(VAL)                  \
     do {                                \
@@ -26,15 +37,319 @@
 
 static const char *TAG = "WiFi";
 
+struct reconnect_policy {
+    uint32_t initial_ms;
+    uint32_t max_ms;
+};
+
+/* link loss - AP most likely still there, retry fast */
+static const struct reconnect_policy policy_fast = { .initial_ms = 250, .max_ms = 10000 };
+/* AP not found, rebooting or overloaded */
+static const struct reconnect_policy policy_default = { .initial_ms = 2000, .max_ms = 60000 };
+/* wrong credentials - retrying often won't help */
+static const struct reconnect_policy policy_slow = { .initial_ms = 10000, .max_ms = 300000 };
+
+struct fast_connect_cache {
+    uint8_t  ssid[32];
+    uint8_t  bssid[6];
+    uint8_t  channel;
+    uint32_t ip;
+    uint32_t netmask;
+    uint32_t gw;
+    uint32_t dns;
+    uint8_t  static_boots; // boots on cached address since DHCP lease was taken
+};
+
+#ifndef CONFIG_IDF_TARGET_ESP8266
+static esp_netif_t *sta_netif;
+static esp_netif_t *ap_netif;
+#endif
+
+#ifdef CONFIG_APP_WIFI_FAST_CONNECT
+static bool fast_connect_active; // cached BSSID/IP configuration in use
+static bool fast_connect_online; // cached configuration verified by GOT_IP
+static bool fast_connect_static; // cached address kept for this session, DHCP not running
+#endif
+
+static esp_timer_handle_t          reconnect_timer;
+static uint8_t                     reconnect_backoff;
+static int64_t                     disconnect_time;
+static struct wifi_reconnect_stats reconnect_stats;
+
+static const struct reconnect_policy *reconnect_policy_get(uint8_t reason)
+{
+    switch (reason) {
+    case WIFI_REASON_BEACON_TIMEOUT:
+    case WIFI_REASON_AUTH_EXPIRE:
+    case WIFI_REASON_ASSOC_EXPIRE:
+        return &policy_fast;
+    case WIFI_REASON_AUTH_FAIL:
+    case WIFI_REASON_HANDSHAKE_TIMEOUT:
+    case WIFI_REASON_4WAY_HANDSHAKE_TIMEOUT:
+        return &policy_slow;
+    default:
+        return &policy_default;
+    }
+}
+
+static void reconnect_timer_callback(void *arg)
+{
+    reconnect_stats.attempts++;
+    ESP_LOGI(TAG, "reconnect attempt %" PRIu32, reconnect_stats.attempts);
+    esp_wifi_connect();
+}
+
+static void reconnect_schedule(uint8_t reason)
+{
+    const struct reconnect_policy *policy = reconnect_policy_get(reason);
+    uint32_t                       delay_ms = policy->initial_ms;
+
+    for (uint8_t i = 0; i < reconnect_backoff && delay_ms < policy->max_ms; i++)
+        delay_ms *= 2;
+    if (delay_ms > policy->max_ms)
+        delay_ms = policy->max_ms;
+    else
+        reconnect_backoff++;
+
+    /* equal jitter: keep half of the delay, randomize the rest to spread the fleet */
+    delay_ms = delay_ms / 2 + esp_random() % (delay_ms / 2 + 1);
+    reconnect_stats.next_delay_ms = delay_ms;
+
+    ESP_LOGI(TAG, "reconnect in %" PRIu32 "ms (reason %d)", delay_ms, reason);
+    esp_timer_stop(reconnect_timer);
+    esp_timer_start_once(reconnect_timer, (uint64_t)delay_ms * 1000);
+}
+
+static void reconnect_cancel(void)
+{
+    esp_timer_stop(reconnect_timer);
+    reconnect_backoff = 0;
+    disconnect_time = 0;
+}
+
+#ifdef CONFIG_APP_WIFI_FAST_CONNECT
+static esp_err_t fast_connect_cache_read(struct fast_connect_cache *fc)
+{
+    nvs_handle_t nvs;
+    size_t       len = sizeof(*fc);
+    esp_err_t    rc;
+
+    rc = nvs_open(FAST_CONNECT_NVS_NAMESPACE, NVS_READONLY, &nvs);
+    if (rc != ESP_OK)
+        return rc;
+
+    rc = nvs_get_blob(nvs, FAST_CONNECT_NVS_KEY, fc, &len);
+    nvs_close(nvs);
+    if (rc == ESP_OK && len != sizeof(*fc))
+        rc = ESP_ERR_INVALID_SIZE;
+    return rc;
+}
+
+static esp_err_t fast_connect_cache_write(const struct fast_connect_cache *fc)
+{
+    nvs_handle_t nvs;
+    esp_err_t    rc;
+
+    rc = nvs_open(FAST_CONNECT_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (rc != ESP_OK)
+        return rc;
+
+    rc = nvs_set_blob(nvs, FAST_CONNECT_NVS_KEY, fc, sizeof(*fc));
+    if (rc == ESP_OK)
+        rc = nvs_commit(nvs);
+    nvs_close(nvs);
+    device_metrics_nvs_write();
+    return rc;
+}
+
+static void sta_set_ip_config(const struct fast_connect_cache *fc)
+{
+    ip_addr_t dns_addr;
+
+#ifdef CONFIG_IDF_TARGET_ESP8266
+    tcpip_adapter_ip_info_t ip_info;
+
+    if (!fc) {
+        tcpip_adapter_dhcpc_start(TCPIP_ADAPTER_IF_STA);
+        return;
+    }
+    ip_info.ip.addr = fc->ip;
+    ip_info.netmask.addr = fc->netmask;
+    ip_info.gw.addr = fc->gw;
+    tcpip_adapter_dhcpc_stop(TCPIP_ADAPTER_IF_STA);
+    tcpip_adapter_set_ip_info(TCPIP_ADAPTER_IF_STA, &ip_info);
+#else
+    esp_netif_ip_info_t ip_info;
+
+    if (!fc) {
+        esp_netif_dhcpc_start(sta_netif);
+        return;
+    }
+    ip_info.ip.addr = fc->ip;
+    ip_info.netmask.addr = fc->netmask;
+    ip_info.gw.addr = fc->gw;
+    esp_netif_dhcpc_stop(sta_netif);
+    esp_netif_set_ip_info(sta_netif, &ip_info);
+#endif
+    ip_addr_set_ip4_u32(&dns_addr, fc->dns);
+    dns_setserver(0, &dns_addr);
+}
+
+static void sta_set_ap_config(const uint8_t *bssid, uint8_t channel)
+{
+    wifi_config_t wifi_config;
+
+    esp_wifi_get_config(ESP_IF_WIFI_STA, &wifi_config);
+    wifi_config.sta.bssid_set = bssid ? true : false;
+    if (bssid)
+        memcpy(wifi_config.sta.bssid, bssid, sizeof(wifi_config.sta.bssid));
+    wifi_config.sta.channel = channel;
+
+    /* don't wear flash with temporary AP settings */
+    esp_wifi_set_storage(WIFI_STORAGE_RAM);
+    esp_wifi_set_config(ESP_IF_WIFI_STA, &wifi_config);
+    esp_wifi_set_storage(WIFI_STORAGE_FLASH);
+}
+
+static void fast_connect_setup(void)
+{
+    struct fast_connect_cache fc;
+    wifi_config_t             wifi_config;
+
+    if (fast_connect_cache_read(&fc) != ESP_OK)
+        return;
+
+    esp_wifi_get_config(ESP_IF_WIFI_STA, &wifi_config);
+    if (memcmp(fc.ssid, wifi_config.sta.ssid, sizeof(fc.ssid)) != 0)
+        return; // network changed since last connect
+
+    ESP_LOGI(TAG, "fast connect: channel %d", fc.channel);
+    sta_set_ap_config(fc.bssid, fc.channel);
+    // lease was not renewed while cached address was used, take it again now and then
+    fast_connect_static = fc.static_boots < CONFIG_APP_WIFI_FAST_CONNECT_STATIC_BOOTS;
+    if (fast_connect_static)
+        sta_set_ip_config(&fc);
+    else
+        ESP_LOGI(TAG, "fast connect: lease may be stale, using DHCP");
+    fast_connect_active = true;
+    fast_connect_online = false;
+    reconnect_stats.fast_connects++;
+}
+
+static void fast_connect_fallback(void)
+{
+    if (!fast_connect_online) {
+        ESP_LOGW(TAG, "fast connect failed, fallback to scan + DHCP");
+        reconnect_stats.fast_fallbacks++;
+    }
+    sta_set_ap_config(NULL, 0);
+    if (fast_connect_static)
+        sta_set_ip_config(NULL); // link is down, DHCP does not break it
+    fast_connect_active = false;
+    fast_connect_static = false;
+}
+
+static void fast_connect_update(const ip_event_got_ip_t *event)
+{
+    struct fast_connect_cache fc = {};
+    struct fast_connect_cache stored;
+    wifi_config_t             wifi_config;
+    wifi_ap_record_t          ap_info;
+
+    if (fast_connect_active && !fast_connect_online) {
+        fast_connect_online = true;
+        /* cached address is kept until next disconnect: starting DHCP now would
+         * reset the interface under just opened sockets */
+        if (fast_connect_static) {
+            if (fast_connect_cache_read(&stored) == ESP_OK) {
+                stored.static_boots++;
+                fast_connect_cache_write(&stored);
+            }
+            return;
+        }
+    }
+    if (esp_wifi_sta_get_ap_info(&ap_info) != ESP_OK)
+        return;
+
+    esp_wifi_get_config(ESP_IF_WIFI_STA, &wifi_config);
+    memcpy(fc.ssid, wifi_config.sta.ssid, sizeof(fc.ssid));
+    memcpy(fc.bssid, ap_info.bssid, sizeof(fc.bssid));
+    fc.channel = ap_info.primary;
+    fc.ip = event->ip_info.ip.addr;
+    fc.netmask = event->ip_info.netmask.addr;
+    fc.gw = event->ip_info.gw.addr;
+    fc.dns = ip4_addr_get_u32(ip_2_ip4(dns_getserver(0)));
+
+    if (fast_connect_cache_read(&stored) == ESP_OK && !memcmp(&stored, &fc, sizeof(fc)))
+        return;
+
+    ESP_LOGI(TAG, "fast connect cache update");
+    fast_connect_cache_write(&fc);
+}
+#endif
+
+static void wifi_event_handler(void *arg, esp_event_base_t base, int32_t id, void *data)
+{
+    if (base == WIFI_EVENT && id == WIFI_EVENT_STA_DISCONNECTED) {
+        wifi_event_sta_disconnected_t *info = data;
+
+        reconnect_stats.disconnects++;
+        reconnect_stats.last_reason = info->reason;
+        if (info->reason == WIFI_REASON_ASSOC_LEAVE)
+            return; // disconnected by user
+
+        if (!disconnect_time)
+            disconnect_time = esp_timer_get_time();
+#ifdef CONFIG_APP_WIFI_FAST_CONNECT
+        if (fast_connect_active) {
+            /* cached AP or lease may be stale: retry at once with scan + DHCP */
+            bool online = fast_connect_online;
+            fast_connect_fallback();
+            if (!online) {
+                esp_wifi_connect();
+                return;
+            }
+        }
+#endif
+        reconnect_schedule(info->reason);
+    } else if (base == IP_EVENT && id == IP_EVENT_STA_GOT_IP) {
+        if (disconnect_time) {
+            uint32_t reconnect_ms = (esp_timer_get_time() - disconnect_time) / 1000;
+
+            reconnect_stats.reconnects++;
+            reconnect_stats.last_reconnect_ms = reconnect_ms;
+            reconnect_stats.total_reconnect_ms += reconnect_ms;
+            if (reconnect_ms > reconnect_stats.max_reconnect_ms)
+                reconnect_stats.max_reconnect_ms = reconnect_ms;
+            ESP_LOGI(TAG, "reconnected after %" PRIu32 "ms", reconnect_ms);
+        }
+        reconnect_cancel();
+#ifdef CONFIG_APP_WIFI_FAST_CONNECT
+        fast_connect_update(data);
+#endif
+    }
+}
+
 esp_err_t wifi_init(esp_event_handler_t eh)
 {
+    const esp_timer_create_args_t timer_args = {
+        .name = "wifi-reconnect",
+        .dispatch_method = ESP_TIMER_TASK,
+        .callback = reconnect_timer_callback,
+    };
+
+    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &reconnect_timer));
     ESP_ERROR_CHECK(esp_netif_init());
     ESP_ERROR_CHECK(esp_event_handler_register(WIFI_EVENT, ESP_EVENT_ANY_ID, eh, NULL));
     ESP_ERROR_CHECK(esp_event_handler_register(IP_EVENT, ESP_EVENT_ANY_ID, eh, NULL));
+    ESP_ERROR_CHECK(esp_event_handler_register(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED,
+                                               wifi_event_handler, NULL));
+    ESP_ERROR_CHECK(
+        esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, wifi_event_handler, NULL));
 
 #ifndef CONFIG_IDF_TARGET_ESP8266
-    esp_netif_create_default_wifi_ap();
-    esp_netif_create_default_wifi_sta();
+    ap_netif = esp_netif_create_default_wifi_ap();
+    sta_netif = esp_netif_create_default_wifi_sta();
 #endif
 
     wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
@@ -47,8 +362,13 @@ esp_err_t wifi_init(esp_event_handler_t eh)
 esp_err_t wifi_set_station_mode(void)
 {
     ESP_LOGI(TAG, "set station mode");
+    reconnect_cancel();
     ESP_ERROR_CHECK(esp_wifi_stop());
     ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
+#ifdef CONFIG_APP_WIFI_FAST_CONNECT
+    if (!fast_connect_active)
+        fast_connect_setup();
+#endif
     ESP_ERROR_CHECK(esp_wifi_start());
     ESP_ERROR_CHECK(esp_wifi_connect());
     return ESP_OK;
@@ -67,6 +387,7 @@ esp_err_t wifi_set_access_point_mode(const char *ap_ssid)
     wifi_config.ap.ssid_len = strlen((char *)wifi_config.ap.ssid);
 
     ESP_LOGI(TAG, "set AP mode with SSID: %s", wifi_config.ap.ssid);
+    reconnect_cancel();
     esp_wifi_disconnect();
     ESP_ERROR_CHECK(esp_wifi_stop());
     ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_APSTA));
@@ -74,3 +395,55 @@ esp_err_t wifi_set_access_point_mode(const char *ap_ssid)
     ESP_ERROR_CHECK(esp_wifi_start());
     return ESP_OK;
 }
+
+esp_err_t wifi_get_reconnect_stats(struct wifi_reconnect_stats *stats)
+{
+    CHECK_ARG(stats);
+
+    *stats = reconnect_stats;
+    return ESP_OK;
+}
+
+#ifdef CONFIG_IDF_TARGET_ESP8266
+static esp_err_t get_ip_info(tcpip_adapter_if_t netif, struct wifi_ip_info *info)
+{
+    tcpip_adapter_ip_info_t ip_info;
+    esp_err_t               rc;
+
+    CHECK_ARG(info);
+    rc = tcpip_adapter_get_ip_info(netif, &ip_info);
+#else
+static esp_err_t get_ip_info(esp_netif_t *netif, struct wifi_ip_info *info)
+{
+    esp_netif_ip_info_t ip_info;
+    esp_err_t           rc;
+
+    CHECK_ARG(info);
+    rc = esp_netif_get_ip_info(netif, &ip_info);
+#endif
+    if (rc != ESP_OK)
+        return rc;
+
+    info->ip = ip_info.ip.addr;
+    info->netmask = ip_info.netmask.addr;
+    info->gw = ip_info.gw.addr;
+    return ESP_OK;
+}
+
+esp_err_t wifi_get_sta_ip_info(struct wifi_ip_info *info)
+{
+#ifdef CONFIG_IDF_TARGET_ESP8266
+    return get_ip_info(TCPIP_ADAPTER_IF_STA, info);
+#else
+    return get_ip_info(sta_netif, info);
+#endif
+}
+
+esp_err_t wifi_get_ap_ip_info(struct wifi_ip_info *info)
+{
+#ifdef CONFIG_IDF_TARGET_ESP8266
+    return get_ip_info(TCPIP_ADAPTER_IF_AP, info);
+#else
+    return get_ip_info(ap_netif, info);
+#endif
+}
@@ -11,10 +11,33 @@
 #include <esp_wifi.h>
 #include <esp_event.h>
 
+struct wifi_reconnect_stats {
+    uint32_t disconnects;        // station disconnect events
+    uint32_t attempts;           // reconnect attempts made by scheduler
+    uint8_t  last_reason;        // last WIFI_REASON_* code
+    uint32_t next_delay_ms;      // delay of pending/last scheduled attempt
+    uint32_t last_reconnect_ms;  // time from disconnect to IP for last reconnect
+    uint32_t max_reconnect_ms;   // longest time from disconnect to IP
+    uint32_t total_reconnect_ms; // sum of all completed reconnect times
+    uint32_t reconnects;         // completed reconnects
+    uint32_t fast_connects;      // connects made with cached BSSID/IP
+    uint32_t fast_fallbacks;     // fast connects that fell back to scan + DHCP
+};
+
+struct wifi_ip_info {
+    uint32_t ip;
+    uint32_t netmask;
+    uint32_t gw;
+};
+
 esp_err_t wifi_init(esp_event_handler_t eh);
 bool      wifi_sta_configured(void);
 
 esp_err_t wifi_set_station_mode(void);
 esp_err_t wifi_set_access_point_mode(const char *ap_ssid);
 
+esp_err_t wifi_get_reconnect_stats(struct wifi_reconnect_stats *stats);
+esp_err_t wifi_get_sta_ip_info(struct wifi_ip_info *info);
+esp_err_t wifi_get_ap_ip_info(struct wifi_ip_info *info);
+
 #endif /* MAIN_WIFI_H_ */
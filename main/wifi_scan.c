@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2025 <qb4.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "wifi_scan.h"
+#include <stdlib.h>
+#include <string.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <esp_wifi.h>
+#include <cJSON.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+#define WIFI_SCAN_RECORDS_MAX 24
+#define WIFI_SCAN_MAX_AGE_US (30 * 1000 * 1000)
+
+static const char *TAG = "WIFI-SCAN";
+
+static struct wifi_scan_cache scan_cache;
+static SemaphoreHandle_t      scan_mutex;
+
+// keeps strongest entry of each SSID, list is sorted by RSSI
+static void scan_cache_add(struct wifi_scan_cache *cache, const wifi_ap_record_t *rec)
+{
+    struct wifi_scan_ap ap = { .rssi = rec->rssi, .authmode = rec->authmode };
+    int                 i;
+
+    if (!rec->ssid[0])
+        return; // hidden network
+
+    for (i = 0; i < cache->num; i++) {
+        if (!strcmp(cache->aps[i].ssid, (const char *)rec->ssid)) {
+            if (cache->aps[i].rssi >= rec->rssi)
+                return;
+            // remove weaker entry, stronger one is inserted below
+            memmove(&cache->aps[i], &cache->aps[i + 1],
+                    (cache->num - i - 1) * sizeof(struct wifi_scan_ap));
+            cache->num--;
+            break;
+        }
+    }
+    if (cache->num == WIFI_SCAN_CACHE_MAX) {
+        if (cache->aps[cache->num - 1].rssi >= rec->rssi)
+            return;
+        cache->num--;
+    }
+
+    strncpy(ap.ssid, (const char *)rec->ssid, sizeof(ap.ssid) - 1);
+    ap.channel = rec->primary;
+    for (i = cache->num; i > 0 && cache->aps[i - 1].rssi < ap.rssi; i--)
+        cache->aps[i] = cache->aps[i - 1];
+    cache->aps[i] = ap;
+    cache->num++;
+}
+
+static void scan_done_handler(void *arg, esp_event_base_t base, int32_t id, void *data)
+{
+    static struct wifi_scan_cache result;
+    wifi_event_sta_scan_done_t   *info = data;
+    wifi_ap_record_t             *records;
+    uint16_t                      num = WIFI_SCAN_RECORDS_MAX;
+    bool                          own_scan;
+
+    // records of scans started elsewhere (e.g. blocking /wifi scan) belong to their caller
+    xSemaphoreTake(scan_mutex, portMAX_DELAY);
+    own_scan = scan_cache.scanning;
+    xSemaphoreGive(scan_mutex);
+    if (!own_scan)
+        return;
+
+    memset(&result, 0, sizeof(result));
+    records = malloc(num * sizeof(wifi_ap_record_t));
+    // records are fetched even on failure to free driver memory
+    if (records && esp_wifi_scan_get_ap_records(&num, records) == ESP_OK && !info->status) {
+        for (int i = 0; i < num; i++)
+            scan_cache_add(&result, &records[i]);
+    }
+    free(records);
+
+    xSemaphoreTake(scan_mutex, portMAX_DELAY);
+    if (!info->status) {
+        memcpy(scan_cache.aps, result.aps, sizeof(result.aps));
+        scan_cache.num = result.num;
+        scan_cache.updated_at = esp_timer_get_time();
+    }
+    scan_cache.scanning = false;
+    xSemaphoreGive(scan_mutex);
+    ESP_LOGI(TAG, "scan done: %d networks", result.num);
+}
+
+esp_err_t wifi_scan_init(void)
+{
+    scan_mutex = xSemaphoreCreateMutex();
+    if (!scan_mutex)
+        return ESP_ERR_NO_MEM;
+    return esp_event_handler_register(WIFI_EVENT, WIFI_EVENT_SCAN_DONE, scan_done_handler, NULL);
+}
+
+esp_err_t wifi_scan_start(void)
+{
+    wifi_scan_config_t config = { .show_hidden = false };
+    esp_err_t          rc = ESP_OK;
+
+    xSemaphoreTake(scan_mutex, portMAX_DELAY);
+    if (!scan_cache.scanning) {
+        rc = esp_wifi_scan_start(&config, false);
+        scan_cache.scanning = rc == ESP_OK;
+    }
+    xSemaphoreGive(scan_mutex);
+    if (rc != ESP_OK)
+        ESP_LOGW(TAG, "scan start: %s", esp_err_to_name(rc));
+    return rc;
+}
+
+esp_err_t wifi_scan_get(struct wifi_scan_cache *cache)
+{
+    if (!cache)
+        return ESP_ERR_INVALID_ARG;
+
+    xSemaphoreTake(scan_mutex, portMAX_DELAY);
+    *cache = scan_cache;
+    xSemaphoreGive(scan_mutex);
+    return ESP_OK;
+}
+
+esp_err_t wifi_scan_httpd_handler(httpd_req_t *req)
+{
+    static struct wifi_scan_cache cache; // too big for httpd stack
+    int64_t                       now = esp_timer_get_time();
+    cJSON                        *js, *aps;
+    char                         *js_txt;
+    esp_err_t                     rc;
+
+    wifi_scan_get(&cache);
+    if (!cache.scanning && (!cache.updated_at || now - cache.updated_at > WIFI_SCAN_MAX_AGE_US))
+        cache.scanning = wifi_scan_start() == ESP_OK;
+
+    js = cJSON_CreateObject();
+    if (!js)
+        return httpd_resp_send_500(req);
+
+    cJSON_AddBoolToObject(js, "scanning", cache.scanning);
+    cJSON_AddNumberToObject(js, "age_ms",
+                            cache.updated_at ? (now - cache.updated_at) / 1000 : -1);
+    aps = cJSON_CreateArray();
+    for (int i = 0; i < cache.num; i++) {
+        cJSON *ap = cJSON_CreateObject();
+
+        cJSON_AddStringToObject(ap, "ssid", cache.aps[i].ssid);
+        cJSON_AddNumberToObject(ap, "rssi", cache.aps[i].rssi);
+        cJSON_AddNumberToObject(ap, "authmode", cache.aps[i].authmode);
+        cJSON_AddNumberToObject(ap, "channel", cache.aps[i].channel);
+        cJSON_AddItemToArray(aps, ap);
+    }
+    cJSON_AddItemToObject(js, "aps", aps);
+
+    js_txt = cJSON_PrintUnformatted(js);
+    cJSON_Delete(js);
+    if (!js_txt)
+        return httpd_resp_send_500(req);
+
+    httpd_resp_set_type(req, HTTPD_TYPE_JSON);
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    rc = httpd_resp_sendstr(req, js_txt);
+    free(js_txt);
+    return rc;
+}
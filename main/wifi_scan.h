@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2025 <qb4.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#ifndef MAIN_WIFI_SCAN_H_
+#define MAIN_WIFI_SCAN_H_
+
+#include <stdbool.h>
+#include <esp_err.h>
+#include <esp_http_server.h>
+
+#define WIFI_SCAN_CACHE_MAX 16
+
+struct wifi_scan_ap {
+    char    ssid[33];
+    int8_t  rssi;
+    uint8_t authmode;
+    uint8_t channel;
+};
+
+struct wifi_scan_cache {
+    int64_t             updated_at; // esp_timer time of last scan, 0 when never scanned
+    bool                scanning;
+    uint8_t             num;
+    struct wifi_scan_ap aps[WIFI_SCAN_CACHE_MAX]; // one per SSID, strongest first
+};
+
+esp_err_t wifi_scan_init(void);
+
+/**
+ * @brief Start scan in background, cache is updated when it is done
+ *
+ */
+esp_err_t wifi_scan_start(void);
+esp_err_t wifi_scan_get(struct wifi_scan_cache *cache);
+
+/**
+ * @brief Return cached networks at once, stale cache triggers a new scan
+ *
+ * Clients poll again while "scanning" is true.
+ */
+esp_err_t wifi_scan_httpd_handler(httpd_req_t *req);
+
+#endif /* MAIN_WIFI_SCAN_H_ */
@@ -0,0 +1,300 @@
+/*
+ * Copyright (c) 2025 <qb4.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+/*
+ * Captive portal DNS responder of main/captive.c run in a thread on loopback.
+ * Queries are made with glibc resolver like a client connected to the AP, and
+ * packets no resolver sends are checked to get no reply.
+ * Exit status is nonzero when any answer differs from the expected one.
+ */
+
+#include <netdb.h>
+#include <pthread.h>
+#include <resolv.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <arpa/nameser.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <captive.h>
+#include <device.h>
+#include <wifi.h>
+
+#define SIM_AP_IP "192.168.4.1"
+#define SIM_NO_REPLY_MS 200
+
+struct host_task {
+    pthread_t      thread;
+    TaskFunction_t fn;
+    void          *arg;
+};
+
+int host_verbose;
+
+static volatile EventBits_t event_bits = DEVICE_CONFIG_EVENT_BIT;
+static volatile in_port_t   dns_port; // where responder got bound, network order
+static struct host_task     dns_task;
+
+static void *host_task_run(void *arg)
+{
+    struct host_task *task = arg;
+
+    task->fn(task->arg);
+    return NULL;
+}
+
+// single task is started by tested code
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack, void *arg,
+                       int prio, TaskHandle_t *handle)
+{
+    dns_task.fn = fn;
+    dns_task.arg = arg;
+    if (pthread_create(&dns_task.thread, NULL, host_task_run, &dns_task))
+        return pdFALSE;
+    if (handle)
+        *handle = &dns_task;
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    pthread_exit(NULL);
+}
+
+int host_bind(int sock, const struct sockaddr *addr, socklen_t len)
+{
+    struct sockaddr_in in = { .sin_family = AF_INET };
+    socklen_t          in_len = sizeof(in);
+
+    in.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(sock, (struct sockaddr *)&in, sizeof(in)) < 0 ||
+        getsockname(sock, (struct sockaddr *)&in, &in_len) < 0)
+        return -1;
+    dns_port = in.sin_port;
+    return 0;
+}
+
+EventBits_t device_get_event_bits(void)
+{
+    return event_bits;
+}
+
+esp_err_t wifi_get_ap_ip_info(struct wifi_ip_info *info)
+{
+    info->ip = inet_addr(SIM_AP_IP);
+    info->netmask = inet_addr("255.255.255.0");
+    info->gw = info->ip;
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_status(httpd_req_t *req, const char *status)
+{
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_hdr(httpd_req_t *req, const char *field, const char *value)
+{
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_send(httpd_req_t *req, const char *buf, ssize_t len)
+{
+    return ESP_OK;
+}
+
+esp_err_t httpd_register_uri_handler(httpd_handle_t handle, const httpd_uri_t *uri)
+{
+    return ESP_OK;
+}
+
+static struct sockaddr_in sim_dns_addr(void)
+{
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_port = dns_port };
+
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    return addr;
+}
+
+/*
+ * Query made by resolver, returns answer count or -1 with resolver error.
+ * First A record address is stored in ip.
+ */
+static int sim_resolve(const char *name, int type, bool edns, uint32_t *ip, uint32_t *ttl,
+                       int *err)
+{
+    struct __res_state res = {};
+    uint8_t            answer[NS_PACKETSZ];
+    ns_msg             msg;
+    ns_rr              rr;
+    int                len, count;
+
+    if (res_ninit(&res))
+        return -1;
+    res.nsaddr_list[0] = sim_dns_addr();
+    res.nscount = 1;
+    res.retrans = 1;
+    res.retry = 1;
+    if (edns)
+        res.options |= RES_USE_EDNS0;
+
+    len = res_nquery(&res, name, ns_c_in, type, answer, sizeof(answer));
+    *err = res.res_h_errno;
+    res_nclose(&res);
+    if (len < 0 || ns_initparse(answer, len, &msg) < 0)
+        return -1;
+
+    count = ns_msg_count(msg, ns_s_an);
+    for (int i = 0; i < count; i++) {
+        if (ns_parserr(&msg, ns_s_an, i, &rr) < 0)
+            return -1;
+        if (ns_rr_type(rr) == ns_t_a && ns_rr_rdlen(rr) == 4) {
+            memcpy(ip, ns_rr_rdata(rr), 4);
+            *ttl = ns_rr_ttl(rr);
+            break;
+        }
+    }
+    return count;
+}
+
+// raw packet exchange, returns reply length, 0 when there was no reply
+static int sim_exchange(const uint8_t *query, size_t len, uint8_t *reply, size_t size)
+{
+    struct sockaddr_in addr = sim_dns_addr();
+    struct timeval     tv = { .tv_usec = SIM_NO_REPLY_MS * 1000 };
+    int                sock, rc;
+
+    sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock < 0)
+        return -1;
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    rc = sendto(sock, query, len, 0, (struct sockaddr *)&addr, sizeof(addr));
+    if (rc == len)
+        rc = recv(sock, reply, size, 0);
+    close(sock);
+    return rc < 0 ? 0 : rc;
+}
+
+static bool sim_check(const char *name, bool ok)
+{
+    printf("  %-36s %s\n", name, ok ? "ok" : "FAIL");
+    return ok;
+}
+
+static bool sim_resolver_queries(void)
+{
+    const uint32_t ap_ip = inet_addr(SIM_AP_IP);
+    uint32_t       ip, ttl;
+    bool           ok = true;
+    int            count, err;
+
+    printf("resolver queries\n");
+    ip = ttl = 0;
+    count = sim_resolve("connectivitycheck.gstatic.com", ns_t_a, false, &ip, &ttl, &err);
+    ok = sim_check("A", count == 1 && ip == ap_ip && ttl == 60) && ok;
+
+    ip = ttl = 0;
+    count = sim_resolve("captive.apple.com", ns_t_a, true, &ip, &ttl, &err);
+    ok = sim_check("A with EDNS", count == 1 && ip == ap_ip && ttl == 60) && ok;
+
+    // NOERROR with no answer, client falls back to A query
+    count = sim_resolve("www.msftconnecttest.com", ns_t_aaaa, false, &ip, &ttl, &err);
+    ok = sim_check("AAAA, empty answer", count < 0 && err == NO_DATA) && ok;
+
+    count = sim_resolve("detectportal.firefox.com", ns_t_aaaa, true, &ip, &ttl, &err);
+    ok = sim_check("AAAA with EDNS, empty answer", count < 0 && err == NO_DATA) && ok;
+    return ok;
+}
+
+static bool sim_raw_queries(void)
+{
+    // id, flags RD, 1 question, 1 additional; "portal.lan" A IN; OPT record
+    static const uint8_t edns_query[] = {
+        0x12, 0x34, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x06, 'p',
+        'o',  'r',  't',  'a',  'l',  0x03, 'l',  'a',  'n',  0x00, 0x00, 0x01, 0x00, 0x01,
+        0x00, 0x00, 0x29, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    };
+    const size_t question_end = 28;
+    uint8_t      query[sizeof(edns_query)];
+    uint8_t      reply[NS_PACKETSZ];
+    bool         ok = true;
+    int          len;
+
+    printf("raw packets\n");
+    len = sim_exchange(edns_query, sizeof(edns_query), reply, sizeof(reply));
+    ok = sim_check("A with OPT, record dropped",
+                   len == question_end + 16 && reply[0] == 0x12 && reply[1] == 0x34 &&
+                       reply[2] == 0x85 && reply[3] == 0x80 && reply[7] == 1 && reply[11] == 0 &&
+                       !memcmp(reply + len - 4, &(uint32_t){ inet_addr(SIM_AP_IP) }, 4)) &&
+         ok;
+
+    len = sim_exchange(edns_query, 7, reply, sizeof(reply));
+    ok = sim_check("short header, no reply", len == 0) && ok;
+
+    len = sim_exchange(edns_query, 20, reply, sizeof(reply));
+    ok = sim_check("truncated question, no reply", len == 0) && ok;
+
+    memcpy(query, edns_query, sizeof(query));
+    query[5] = 2;
+    len = sim_exchange(query, sizeof(query), reply, sizeof(reply));
+    ok = sim_check("two questions, no reply", len == 0) && ok;
+
+    memcpy(query, edns_query, sizeof(query));
+    query[19] = 0xc0; // ".lan" replaced with pointer to header
+    query[20] = 0x00;
+    len = sim_exchange(query, sizeof(query), reply, sizeof(reply));
+    ok = sim_check("compressed question, no reply", len == 0) && ok;
+
+    // replying to responses would loop between two responders
+    memcpy(query, edns_query, sizeof(query));
+    query[2] |= 0x80;
+    len = sim_exchange(query, sizeof(query), reply, sizeof(reply));
+    ok = sim_check("response packet, no reply", len == 0) && ok;
+
+    memcpy(query, edns_query, sizeof(query));
+    query[2] = 0x28; // opcode UPDATE
+    len = sim_exchange(query, sizeof(query), reply, sizeof(reply));
+    ok = sim_check("update opcode, no reply", len == 0) && ok;
+    return ok;
+}
+
+int main(int argc, char *argv[])
+{
+    bool ok = true;
+    int  opt;
+
+    while ((opt = getopt(argc, argv, "v")) != -1) {
+        if (opt == 'v') {
+            host_verbose = 1;
+        } else {
+            fprintf(stderr, "usage: %s [-v]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (captive_dns_start() != ESP_OK) {
+        printf("responder not started\nFAILED\n");
+        return 1;
+    }
+    for (int i = 0; i < 100 && !dns_port; i++)
+        usleep(10000);
+    if (!dns_port) {
+        printf("responder not bound\nFAILED\n");
+        return 1;
+    }
+
+    ok = sim_resolver_queries() && ok;
+    ok = sim_raw_queries() && ok;
+
+    // responder stops within its receive timeout when config mode ends
+    event_bits = 0;
+    pthread_join(dns_task.thread, NULL);
+
+    printf("%s\n", ok ? "PASSED" : "FAILED");
+    return ok ? 0 : 1;
+}
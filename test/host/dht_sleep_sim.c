@@ -0,0 +1,313 @@
+/*
+ * Copyright (c) 2025 <qb4.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+/*
+ * Wake cycles of battery powered ESP-01 USB DHT board on virtual clock. Board
+ * report logic, DHT channel and device sleep are built from the tree, Wi-Fi
+ * and SUPLA server are simulated. Each wake cycle runs in a new process and
+ * only RTC data is carried over deep sleep, as on target.
+ *
+ * Awake time of each phase is reported: Wi-Fi up, registration on server,
+ * value sent, wait before sleep. Exit status is nonzero when a report is not
+ * sent when it should be, awake time or sleep interval is not as expected.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <board.h>
+#include <button.h>
+#include <dht.h>
+#include <esp_sleep.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+#include "device-priv.h"
+#include "mock.h"
+
+#define SIM_LOOP_US 10000 // supla loop iteration
+#define SIM_AWAKE_MAX_US (60 * 1000000LL)
+#define SIM_CHECK_SLACK_US 100000 // report check interval and loop iterations
+
+struct supla_dev {
+    int unused;
+};
+
+struct sim_cycle {
+    int  ip_ms;     // time to get IP, -1: never
+    int  online_ms; // time to register on server after IP, -1: never
+    bool sensor_ok;
+    bool sent;      // expected report result
+};
+
+struct sim_scenario {
+    const char            *name;
+    const struct sim_cycle cycles[8];
+    int                    cycles_num;
+};
+
+// results of single wake, sent by child process
+struct sim_wake {
+    bool     slept;
+    int64_t  ip_us;
+    int64_t  online_us;
+    int64_t  sent_us;
+    int64_t  sleep_us;
+    int64_t  sleep_for_us;
+    uint32_t deep_sleep_cycles;
+    uint64_t time_ms;
+    float    charge_mah;
+};
+
+extern char __start_host_rtc[], __stop_host_rtc[];
+
+static const struct sim_cycle *cycle;
+static struct sim_wake         wake;
+static bool                    resumed;
+static int                     result_fd = -1;
+static int64_t                 light_sleep_us;
+static struct supla_dev        dev;
+
+esp_reset_reason_t esp_reset_reason(void)
+{
+    return resumed ? ESP_RST_DEEPSLEEP : ESP_RST_POWERON;
+}
+
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t time_in_us)
+{
+    light_sleep_us = time_in_us;
+    return ESP_OK;
+}
+
+esp_err_t esp_light_sleep_start(void)
+{
+    host_run(light_sleep_us);
+    return ESP_OK;
+}
+
+// wake results and RTC memory go to parent, next cycle starts from reset
+void esp_deep_sleep(uint64_t time_in_us)
+{
+    device_sleep_report_t report;
+
+    wake.slept = true;
+    wake.sleep_us = esp_timer_get_time();
+    wake.sleep_for_us = time_in_us;
+    if (device_sleep_get_report(&report) == ESP_OK) {
+        wake.deep_sleep_cycles = report.deep_sleep_cycles;
+        for (int i = 0; i < DEVICE_SLEEP_MODE_MAX; i++) {
+            wake.time_ms += report.time_ms[i];
+            wake.charge_mah += report.charge_mah[i];
+        }
+    }
+    if (write(result_fd, &wake, sizeof(wake)) != sizeof(wake) ||
+        write(result_fd, __start_host_rtc, __stop_host_rtc - __start_host_rtc) < 0)
+        _exit(2);
+    _exit(0);
+}
+
+int supla_dev_add_channel(supla_dev_t *dev, supla_channel_t *ch)
+{
+    return SUPLA_RESULT_TRUE;
+}
+
+int supla_dev_get_state(supla_dev_t *dev, supla_dev_state_t *state)
+{
+    const int64_t now = esp_timer_get_time();
+
+    *state = SUPLA_DEV_STATE_IDLE;
+    if (cycle->ip_ms >= 0 && now >= cycle->ip_ms * 1000LL) {
+        *state = SUPLA_DEV_STATE_CONNECTED;
+        if (cycle->online_ms >= 0 && now >= (cycle->ip_ms + cycle->online_ms) * 1000LL)
+            *state = SUPLA_DEV_STATE_ONLINE;
+    }
+    return SUPLA_RESULT_TRUE;
+}
+
+esp_err_t dht_read_float_data(dht_sensor_type_t type, gpio_num_t pin, float *humidity,
+                              float *temperature)
+{
+    if (!cycle->sensor_ok)
+        return ESP_FAIL;
+
+    *humidity = 45.0f;
+    *temperature = 21.5f;
+    return ESP_OK;
+}
+
+esp_err_t settings_nvs_read(const settings_group_t *pack)
+{
+    return ESP_OK;
+}
+
+setting_t *settings_pack_find(const settings_group_t *pack, const char *group, const char *id)
+{
+    return NULL;
+}
+
+esp_err_t button_init(button_t *btn)
+{
+    return ESP_OK;
+}
+
+/*
+ * Supla loop as in app_main(): values changed before iteration are sent by it
+ * once device is online. Sleep is tried on every iteration instead of after
+ * loop timeout, so awake times are a lower bound.
+ */
+static void sim_wake(void)
+{
+    supla_dev_state_t state;
+
+    device_sleep_init();
+    board_supla_init(&dev);
+    while (esp_timer_get_time() < SIM_AWAKE_MAX_US) {
+        const uint32_t seq = device_update_seq();
+        const int64_t  now = esp_timer_get_time();
+
+        supla_dev_get_state(&dev, &state);
+        if (state >= SUPLA_DEV_STATE_CONNECTED && !wake.ip_us)
+            wake.ip_us = now;
+        if (state == SUPLA_DEV_STATE_ONLINE) {
+            if (!wake.online_us)
+                wake.online_us = now;
+            device_update_sent(seq);
+            if (seq && !wake.sent_us)
+                wake.sent_us = now;
+        }
+        device_sleep_enter();
+        host_run(SIM_LOOP_US);
+    }
+    if (write(result_fd, &wake, sizeof(wake)) != sizeof(wake))
+        _exit(2);
+    _exit(1);
+}
+
+static bool sim_run_cycle(const struct sim_cycle *c, struct sim_wake *res)
+{
+    const size_t rtc_size = __stop_host_rtc - __start_host_rtc;
+    int          fds[2];
+    pid_t        pid;
+    int          status;
+    bool         ok;
+
+    fflush(stdout);
+    if (pipe(fds))
+        return false;
+
+    pid = fork();
+    if (pid == 0) {
+        close(fds[0]);
+        result_fd = fds[1];
+        cycle = c;
+        sim_wake();
+    }
+    close(fds[1]);
+    memset(res, 0, sizeof(*res));
+    ok = pid > 0 && read(fds[0], res, sizeof(*res)) == sizeof(*res);
+    // RTC memory is only retained over deep sleep
+    if (ok && res->slept)
+        ok = read(fds[0], __start_host_rtc, rtc_size) == rtc_size;
+    close(fds[0]);
+    if (pid > 0)
+        waitpid(pid, &status, 0);
+    return ok;
+}
+
+static int sim_ms(int64_t end_us, int64_t start_us)
+{
+    return end_us ? (int)((end_us - start_us) / 1000) : -1;
+}
+
+static bool sim_run_scenario(const struct sim_scenario *sc)
+{
+    uint32_t failures = 0;
+    bool     ok = true;
+
+    printf("%s\n", sc->name);
+    printf("  cycle    wifi  register      send     flush     awake  sleep     result\n");
+    memset(__start_host_rtc, 0, __stop_host_rtc - __start_host_rtc); // power on
+    resumed = false;
+
+    for (int i = 0; i < sc->cycles_num; i++) {
+        const struct sim_cycle *c = &sc->cycles[i];
+        struct sim_wake         w;
+        int64_t                 expect_sleep_us, expect_awake_us;
+        bool                    sent, fail;
+
+        if (!sim_run_cycle(c, &w)) {
+            printf("  %5d  simulation failed\n", i + 1);
+            return false;
+        }
+        resumed = w.slept;
+
+        failures = c->sent ? 0 : failures < 3 ? failures + 1 : failures;
+        expect_sleep_us = (CONFIG_BSP_DHT_REPORT_INTERVAL_S * 1000000LL) << failures;
+        if (c->sent)
+            expect_awake_us = (c->ip_ms + c->online_ms + CONFIG_BSP_DHT_SEND_DELAY_MS) * 1000LL;
+        else
+            expect_awake_us = CONFIG_BSP_DHT_AWAKE_TIMEOUT_MS * 1000LL;
+
+        sent = w.sent_us && w.sleep_us - w.sent_us >= CONFIG_BSP_DHT_SEND_DELAY_MS * 1000LL;
+        fail = !w.slept || sent != c->sent ||
+               w.sleep_us < expect_awake_us || w.sleep_us > expect_awake_us + SIM_CHECK_SLACK_US ||
+               w.sleep_for_us > expect_sleep_us ||
+               w.sleep_for_us < expect_sleep_us - SIM_CHECK_SLACK_US;
+        ok = ok && !fail;
+
+        // phase durations, -1 when phase was not reached
+        printf("  %5d  %6d  %8d  %8d  %8d  %8d  %5ds  %s%s\n", i + 1, sim_ms(w.ip_us, 0),
+               sim_ms(w.online_us, w.ip_us), sim_ms(w.sent_us, w.online_us),
+               sim_ms(w.sent_us ? w.sleep_us : 0, w.sent_us), sim_ms(w.sleep_us, 0),
+               (int)(w.sleep_for_us / 1000000), sent ? "sent" : "not sent",
+               fail ? "  FAIL" : "");
+        if (i == sc->cycles_num - 1 && w.time_ms) {
+            printf("  %" PRIu32 " deep sleep cycles, average current %.1f uA\n",
+                   w.deep_sleep_cycles, w.charge_mah * 3.6e9f / w.time_ms);
+        }
+    }
+    return ok;
+}
+
+#define SIM_OK { 450, 700, true, true }              // fast connect, server reachable
+#define SIM_SERVER_DOWN { 450, -1, true, false }     // IP but no registration
+#define SIM_NO_WIFI { -1, -1, true, false }          // AP not reachable
+#define SIM_SENSOR_FAULT { 450, 700, false, false }  // nothing measured to send
+
+static const struct sim_scenario scenarios[] = {
+    { "server reachable", { SIM_OK, SIM_OK, SIM_OK }, 3 },
+    { "server down, then back",
+      { SIM_OK, SIM_SERVER_DOWN, SIM_SERVER_DOWN, SIM_SERVER_DOWN, SIM_SERVER_DOWN, SIM_OK },
+      6 },
+    { "no Wi-Fi", { SIM_NO_WIFI, SIM_NO_WIFI, SIM_OK }, 3 },
+    { "sensor fault", { SIM_SENSOR_FAULT, SIM_SENSOR_FAULT, SIM_OK }, 3 },
+};
+
+int main(int argc, char *argv[])
+{
+    bool ok = true;
+    int  opt;
+
+    while ((opt = getopt(argc, argv, "v")) != -1) {
+        if (opt == 'v') {
+            host_verbose = 1;
+        } else {
+            fprintf(stderr, "usage: %s [-v]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    printf("times in ms, report interval %ds, awake timeout %dms, send delay %dms\n",
+           CONFIG_BSP_DHT_REPORT_INTERVAL_S, CONFIG_BSP_DHT_AWAKE_TIMEOUT_MS,
+           CONFIG_BSP_DHT_SEND_DELAY_MS);
+    for (int i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++)
+        ok = sim_run_scenario(&scenarios[i]) && ok;
+
+    printf("%s\n", ok ? "PASSED" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,530 @@
+/*
+ * Copyright (c) 2025 <qb4.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "mock.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <esp_log.h>
+#include <esp_partition.h>
+#include <esp_timer.h>
+#include <freertos/semphr.h>
+#include <device.h>
+
+#define HOST_TIMERS_MAX 16
+#define HOST_MUTEXES_MAX 16
+#define HOST_CHANNELS_MAX 8
+#define HOST_NVS_STATE_MAX 256
+#define HOST_JOURNAL_SIZE 0x4000
+
+#define HOST_EVENT_HANDLERS_MAX 8
+
+struct esp_timer {
+    esp_timer_create_args_t args;
+    bool                    used;
+    bool                    armed;
+    int64_t                 fire_us;
+    int64_t                 period_us; // 0 for one-shot
+};
+
+struct host_event_handler {
+    int32_t             id;
+    esp_event_handler_t handler;
+    void               *arg;
+};
+
+struct host_mutex {
+    bool used;
+    bool taken;
+};
+
+struct supla_channel {
+    supla_channel_config_t config;
+    void                  *data;
+    int                    number;
+    int                    func;
+    int                    pos;
+    int                    tilt;
+    uint8_t                nvs[HOST_NVS_STATE_MAX];
+    size_t                 nvs_len;
+};
+
+int               host_verbose;
+int64_t           host_timer_latency_us;
+struct host_stats host_stats;
+
+static int64_t              now_us;
+static uint32_t             rand_state = 1;
+static host_step_cb_t       step_cb;
+static struct esp_timer     timers[HOST_TIMERS_MAX];
+static struct host_mutex    mutexes[HOST_MUTEXES_MAX];
+static struct supla_channel channels[HOST_CHANNELS_MAX];
+static int                  channels_num;
+static int                  gpio_levels[GPIO_NUM_MAX];
+static bool                 journal_enabled;
+static uint8_t              journal_flash[HOST_JOURNAL_SIZE];
+static const esp_partition_t journal_part = { .size = HOST_JOURNAL_SIZE, .label = "rs_journal" };
+static struct host_event_handler event_handlers[HOST_EVENT_HANDLERS_MAX];
+static int                       event_handlers_num;
+static uint32_t                  update_seq;
+static uint32_t                  update_sent_seq;
+
+ESP_EVENT_DEFINE_BASE(DEV_EVENT);
+
+// deterministic, runs are repeatable
+static uint32_t host_rand(void)
+{
+    rand_state = rand_state * 1103515245 + 12345;
+    return rand_state >> 16;
+}
+
+void host_set_step_cb(host_step_cb_t cb)
+{
+    step_cb = cb;
+}
+
+static struct esp_timer *host_timer_due(int64_t until_us)
+{
+    struct esp_timer *due = NULL;
+
+    for (int i = 0; i < HOST_TIMERS_MAX; i++) {
+        if (timers[i].armed && timers[i].fire_us <= until_us &&
+            (!due || timers[i].fire_us < due->fire_us))
+            due = &timers[i];
+    }
+    return due;
+}
+
+void host_run(int64_t duration_us)
+{
+    const int64_t     end_us = now_us + duration_us;
+    struct esp_timer *due;
+    int64_t           next_us;
+
+    while (now_us < end_us) {
+        next_us = now_us + HOST_STEP_US < end_us ? now_us + HOST_STEP_US : end_us;
+        due = host_timer_due(next_us);
+        if (due && due->fire_us > now_us)
+            next_us = due->fire_us;
+        if (step_cb && next_us > now_us)
+            step_cb(now_us, next_us - now_us);
+        now_us = next_us;
+
+        while ((due = host_timer_due(now_us))) {
+            due->armed = due->period_us > 0;
+            due->fire_us += due->period_us;
+            due->args.callback(due->args.arg);
+        }
+    }
+}
+
+int host_gpio_get(gpio_num_t gpio)
+{
+    return (gpio >= 0 && gpio < GPIO_NUM_MAX) ? gpio_levels[gpio] : 0;
+}
+
+void host_journal_enable(bool enable)
+{
+    journal_enabled = enable;
+    memset(journal_flash, 0xff, sizeof(journal_flash));
+}
+
+int host_channel_init(supla_channel_t *ch)
+{
+    return ch->config.on_channel_init ? ch->config.on_channel_init(ch) : 0;
+}
+
+int host_channel_config(supla_channel_t *ch, const void *config, size_t size)
+{
+    TSD_ChannelConfig cfg = {
+        .ChannelNumber = ch->number,
+        .Func = ch->func,
+        .ConfigType = SUPLA_CONFIG_TYPE_DEFAULT,
+        .ConfigSize = size,
+    };
+
+    if (size > sizeof(cfg.Config) || !ch->config.on_config_recv)
+        return ESP_ERR_INVALID_ARG;
+
+    memcpy(cfg.Config, config, size);
+    return ch->config.on_config_recv(ch, &cfg);
+}
+
+void host_channel_value(supla_channel_t *ch, int *pos, int *tilt)
+{
+    *pos = ch->pos;
+    if (tilt)
+        *tilt = ch->tilt;
+}
+
+/* esp_timer */
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *handle)
+{
+    for (int i = 0; i < HOST_TIMERS_MAX; i++) {
+        if (!timers[i].used) {
+            timers[i] = (struct esp_timer){ .args = *args, .used = true };
+            *handle = &timers[i];
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NO_MEM;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    if (timer->armed)
+        return ESP_ERR_INVALID_STATE;
+
+    timer->fire_us = now_us + timeout_us;
+    if (host_timer_latency_us)
+        timer->fire_us += host_rand() % (host_timer_latency_us + 1);
+    timer->period_us = 0;
+    timer->armed = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us)
+{
+    if (timer->armed)
+        return ESP_ERR_INVALID_STATE;
+
+    timer->fire_us = now_us + period_us;
+    timer->period_us = period_us;
+    timer->armed = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    if (!timer->armed)
+        return ESP_ERR_INVALID_STATE;
+
+    timer->armed = false;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+    timer->used = false;
+    timer->armed = false;
+    return ESP_OK;
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return now_us;
+}
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    return code == ESP_OK ? "ESP_OK" : "ESP_ERR";
+}
+
+/* gpio */
+
+esp_err_t gpio_config(const gpio_config_t *config)
+{
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level)
+{
+    if (gpio_num < 0 || gpio_num >= GPIO_NUM_MAX)
+        return ESP_ERR_INVALID_ARG;
+
+    gpio_levels[gpio_num] = level ? 1 : 0;
+    return ESP_OK;
+}
+
+/* FreeRTOS */
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    for (int i = 0; i < HOST_MUTEXES_MAX; i++) {
+        if (!mutexes[i].used) {
+            mutexes[i] = (struct host_mutex){ .used = true };
+            return &mutexes[i];
+        }
+    }
+    return NULL;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t mutex, TickType_t ticks)
+{
+    if (mutex->taken) {
+        host_stats.mutex_errors++;
+        return pdFALSE;
+    }
+    mutex->taken = true;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t mutex)
+{
+    if (!mutex->taken)
+        return pdFALSE;
+
+    mutex->taken = false;
+    return pdTRUE;
+}
+
+/* flash, NOR semantics: writes clear bits only */
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type,
+                                                esp_partition_subtype_t subtype, const char *label)
+{
+    return (journal_enabled && !strcmp(label, journal_part.label)) ? &journal_part : NULL;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *part, size_t offset, void *dst, size_t size)
+{
+    if (offset + size > part->size)
+        return ESP_ERR_INVALID_SIZE;
+
+    memcpy(dst, journal_flash + offset, size);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t *part, size_t offset, const void *src,
+                              size_t size)
+{
+    const uint8_t *p = src;
+
+    if (offset + size > part->size)
+        return ESP_ERR_INVALID_SIZE;
+
+    for (size_t i = 0; i < size; i++)
+        journal_flash[offset + i] &= p[i];
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *part, size_t offset, size_t size)
+{
+    if (offset % 4096 || size % 4096 || offset + size > part->size)
+        return ESP_ERR_INVALID_ARG;
+
+    memset(journal_flash + offset, 0xff, size);
+    return ESP_OK;
+}
+
+/* device */
+
+esp_err_t device_pm_lock_create(device_pm_lock_type_t type, const char *name,
+                                device_pm_lock_handle_t *handle)
+{
+    *handle = NULL;
+    return ESP_OK;
+}
+
+esp_err_t device_pm_lock_acquire(device_pm_lock_handle_t lock)
+{
+    return ESP_OK;
+}
+
+esp_err_t device_pm_lock_release(device_pm_lock_handle_t lock)
+{
+    return ESP_OK;
+}
+
+esp_err_t device_pm_lock_delete(device_pm_lock_handle_t lock)
+{
+    return ESP_OK;
+}
+
+EventBits_t device_get_event_bits(void)
+{
+    return 0;
+}
+
+esp_err_t device_init_config(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t device_exit_config(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t device_event_register(int32_t event_id, esp_event_handler_t handler, void *arg)
+{
+    if (event_handlers_num == HOST_EVENT_HANDLERS_MAX)
+        return ESP_ERR_NO_MEM;
+
+    event_handlers[event_handlers_num++] =
+        (struct host_event_handler){ .id = event_id, .handler = handler, .arg = arg };
+    return ESP_OK;
+}
+
+// dispatched at once, device task is not simulated
+esp_err_t device_event_post(int32_t event_id, const void *data, size_t size)
+{
+    uint8_t buf[DEVICE_EVENT_DATA_MAX];
+
+    if (size > sizeof(buf))
+        return ESP_ERR_INVALID_SIZE;
+
+    for (int i = 0; i < event_handlers_num; i++) {
+        if (event_handlers[i].id == ESP_EVENT_ANY_ID || event_handlers[i].id == event_id) {
+            if (size)
+                memcpy(buf, data, size);
+            event_handlers[i].handler(event_handlers[i].arg, DEV_EVENT, event_id,
+                                      size ? buf : NULL);
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t device_publish(device_event_id_t event_id, void *channel, int32_t code)
+{
+    const device_channel_event_t ev = { .channel = channel, .code = code };
+
+    return device_event_post(event_id, &ev, sizeof(ev));
+}
+
+void device_notify_update(void)
+{
+    update_seq++;
+}
+
+uint32_t device_update_seq(void)
+{
+    return update_seq;
+}
+
+void device_update_sent(uint32_t seq)
+{
+    update_sent_seq = seq;
+}
+
+bool device_update_pending(void)
+{
+    return update_sent_seq != update_seq;
+}
+
+void device_metrics_set_value(void *channel, int64_t start_us)
+{
+}
+
+void device_metrics_nvs_write(void)
+{
+    host_stats.nvs_writes++;
+}
+
+void device_metrics_journal_write(void)
+{
+    host_stats.journal_writes++;
+}
+
+void device_metrics_journal_erase(void)
+{
+    host_stats.journal_erases++;
+}
+
+/* libsupla */
+
+void supla_log(int prio, const char *format, ...)
+{
+    va_list args;
+
+    if (!host_verbose)
+        return;
+
+    printf("  [%8.3f] ", now_us / 1e6);
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+    printf("\n");
+}
+
+supla_channel_t *supla_channel_create(const supla_channel_config_t *config)
+{
+    struct supla_channel *ch;
+
+    if (channels_num == HOST_CHANNELS_MAX)
+        return NULL;
+
+    ch = &channels[channels_num];
+    memset(ch, 0, sizeof(*ch));
+    ch->config = *config;
+    ch->number = channels_num++;
+    ch->func = config->default_function;
+    ch->pos = -1;
+    return ch;
+}
+
+int supla_channel_free(supla_channel_t *ch)
+{
+    return 0;
+}
+
+void *supla_channel_get_data(supla_channel_t *ch)
+{
+    return ch->data;
+}
+
+int supla_channel_set_data(supla_channel_t *ch, void *data)
+{
+    ch->data = data;
+    return 0;
+}
+
+int supla_channel_get_assigned_number(supla_channel_t *ch)
+{
+    return ch->number;
+}
+
+int supla_channel_get_active_function(supla_channel_t *ch, int *func)
+{
+    *func = ch->func;
+    return 0;
+}
+
+int supla_channel_set_active_function(supla_channel_t *ch, int func)
+{
+    ch->func = func;
+    return 0;
+}
+
+int supla_channel_set_roller_shutter_value(supla_channel_t *ch, TDSC_RollerShutterValue *value)
+{
+    ch->pos = value->position;
+    return 0;
+}
+
+int supla_channel_set_facadeblind_value(supla_channel_t *ch, TDSC_FacadeBlindValue *value)
+{
+    ch->pos = value->position;
+    ch->tilt = value->tilt;
+    return 0;
+}
+
+int supla_channel_set_humidtemp_value(supla_channel_t *ch, double humidity, double temp)
+{
+    ch->pos = humidity;
+    ch->tilt = temp;
+    return 0;
+}
+
+esp_err_t supla_esp_nvs_channel_state_store(supla_channel_t *ch, const void *state, size_t len)
+{
+    if (len > sizeof(ch->nvs))
+        return ESP_ERR_INVALID_SIZE;
+
+    memcpy(ch->nvs, state, len);
+    ch->nvs_len = len;
+    return ESP_OK;
+}
+
+esp_err_t supla_esp_nvs_channel_state_restore(supla_channel_t *ch, void *state, size_t len)
+{
+    if (ch->nvs_len != len)
+        return ESP_ERR_NOT_FOUND;
+
+    memcpy(state, ch->nvs, len);
+    return ESP_OK;
+}
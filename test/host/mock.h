@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2025 <qb4.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#ifndef HOST_MOCK_H_
+#define HOST_MOCK_H_
+
+/*
+ * Virtual clock and hardware for host builds: esp_timer callbacks fire on
+ * virtual time, gpio levels are kept for simulated devices, channel values
+ * reported to libsupla and flash writes are recorded.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <esp-supla.h>
+#include <driver/gpio.h>
+
+#define HOST_STEP_US 100 // simulated devices are updated at least this often
+
+struct host_stats {
+    uint32_t nvs_writes;
+    uint32_t journal_writes;
+    uint32_t journal_erases;
+    uint32_t mutex_errors; // mutex taken twice, would deadlock on target
+};
+
+typedef void (*host_step_cb_t)(int64_t now_us, int64_t step_us);
+
+extern int               host_verbose;
+extern int64_t           host_timer_latency_us; // max. extra delay of timer callbacks
+extern struct host_stats host_stats;
+
+void host_set_step_cb(host_step_cb_t cb);
+
+/**
+ * @brief Advance virtual clock, due timers are fired in order
+ *
+ */
+void host_run(int64_t duration_us);
+int  host_gpio_get(gpio_num_t gpio);
+
+/**
+ * @brief Journal partition is found by esp_partition_find_first() when enabled
+ *
+ */
+void host_journal_enable(bool enable);
+
+int  host_channel_init(supla_channel_t *ch);
+int  host_channel_config(supla_channel_t *ch, const void *config, size_t size);
+void host_channel_value(supla_channel_t *ch, int *pos, int *tilt);
+
+#endif /* HOST_MOCK_H_ */
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2025 <qb4.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+/*
+ * Decodes image made by ota_compress.py with main/ota_hs.c and compares it
+ * with original: ota_hs_roundtrip <image.hs> <image.bin>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ota_hs.h>
+
+struct hs_file {
+    FILE  *f;
+    size_t reads;
+};
+
+// short and uneven reads, as from HTTP client
+static int hs_file_read(void *ctx, char *buf, size_t len)
+{
+    struct hs_file *in = ctx;
+    const size_t    chunk = 1 + (in->reads++ * 7) % 61;
+
+    return fread(buf, 1, len < chunk ? len : chunk, in->f);
+}
+
+static uint8_t *load(const char *path, size_t *size)
+{
+    FILE    *f = fopen(path, "rb");
+    uint8_t *data = NULL;
+    long     len;
+
+    if (!f)
+        return NULL;
+    if (!fseek(f, 0, SEEK_END) && (len = ftell(f)) >= 0 && !fseek(f, 0, SEEK_SET)) {
+        data = malloc(len ? len : 1);
+        if (data && fread(data, 1, len, f) != len) {
+            free(data);
+            data = NULL;
+        }
+        *size = len;
+    }
+    fclose(f);
+    return data;
+}
+
+int main(int argc, char *argv[])
+{
+    struct hs_file in = { 0 };
+    uint8_t        hdr[OTA_HS_HEADER_SIZE];
+    uint8_t        window_sz2, lookahead_sz2;
+    uint32_t       size;
+    ota_hs_t       hs;
+    uint8_t       *orig, *out;
+    size_t         orig_size, done = 0;
+    char           buf[333];
+    int            len;
+
+    if (argc != 3) {
+        fprintf(stderr, "usage: %s <image.hs> <image.bin>\n", argv[0]);
+        return 2;
+    }
+    orig = load(argv[2], &orig_size);
+    in.f = fopen(argv[1], "rb");
+    if (!orig || !in.f) {
+        perror("open");
+        return 2;
+    }
+
+    if (fread(hdr, 1, sizeof(hdr), in.f) != sizeof(hdr) ||
+        ota_hs_parse_header(hdr, &window_sz2, &lookahead_sz2, &size) != ESP_OK) {
+        fprintf(stderr, "%s: bad header\n", argv[1]);
+        return 1;
+    }
+    if (size != orig_size) {
+        fprintf(stderr, "%s: size %u, original %u\n", argv[1], size, (unsigned)orig_size);
+        return 1;
+    }
+    if (ota_hs_init(&hs, window_sz2, lookahead_sz2, hs_file_read, &in) != ESP_OK)
+        return 1;
+
+    out = malloc(size + sizeof(buf));
+    while (done < size && (len = ota_hs_read(&hs, buf, sizeof(buf))) > 0) {
+        memcpy(out + done, buf, len);
+        done += len;
+    }
+    ota_hs_deinit(&hs);
+    fclose(in.f);
+
+    if (done != size || memcmp(out, orig, size)) {
+        for (len = 0; len < done && len < size && out[len] == orig[len]; len++)
+            ;
+        fprintf(stderr, "%s: mismatch at %d, decoded %u of %u bytes\n", argv[1], len,
+                (unsigned)done, size);
+        return 1;
+    }
+    printf("%s: w%d l%d %u bytes OK\n", argv[1], window_sz2, lookahead_sz2, size);
+    free(out);
+    free(orig);
+    return 0;
+}
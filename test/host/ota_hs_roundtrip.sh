@@ -0,0 +1,72 @@
+#!/bin/sh
+# Compress test images with main/ota_compress.py and decode them with
+# main/ota_hs.c, compressed sizes are reported:
+#   ota_hs_roundtrip.sh <ota_hs_roundtrip binary> <work dir> [host executable...]
+# Code and read-only data of given host executables, prefixed like an
+# application image, stand in for real firmware. Xtensa and RISC-V code
+# compresses somewhat differently than host code, so ratios are indicative.
+set -e
+
+DECODER=$1
+WORK=$2
+shift 2
+REPO=$(cd "$(dirname "$0")/../.." && pwd)
+PYTHON=${PYTHON:-python3}
+
+mkdir -p "$WORK"
+rm -f "$WORK"/*.bin "$WORK"/*.hs
+"$PYTHON" - "$WORK" "$@" <<'EOF'
+import os, random, struct, sys
+work = sys.argv[1]
+
+
+# .text and .rodata of 64-bit little endian ELF executable
+def elf_code(path):
+    with open(path, 'rb') as f:
+        elf = f.read()
+    if elf[:6] != b'\x7fELF\x02\x01':
+        sys.exit('%s: not a 64-bit little endian ELF file' % path)
+    shoff, = struct.unpack_from('<Q', elf, 0x28)
+    shentsize, shnum, shstrndx = struct.unpack_from('<HHH', elf, 0x3a)
+    sections = [struct.unpack_from('<IIQQQQ', elf, shoff + i * shentsize) for i in range(shnum)]
+    strtab = sections[shstrndx][4]
+    code = b''
+    for name, _, _, _, offset, size in sections:
+        if elf[strtab + name:elf.index(b'\0', strtab + name)] in (b'.text', b'.rodata'):
+            code += elf[offset:offset + size]
+    return code
+
+
+rnd = random.Random(1)
+text = b''.join(b'supla channel %d value %d\n' % (i % 7, i % 13) for i in range(6000))
+images = {
+    'empty': b'',
+    'byte': b'\xe9',
+    'zeros': b'\xe9' + bytes(70000),
+    'random': b'\xe9' + bytes(rnd.getrandbits(8) for _ in range(50000)),
+    'text': b'\xe9' + text,
+    'mixed': b'\xe9' + b''.join(text[i:i + 300] + bytes(rnd.getrandbits(8) for _ in range(40))
+                              for i in range(0, 60000, 300)),
+}
+for path in sys.argv[2:]:
+    images['app-' + os.path.basename(path)] = b'\xe9' + elf_code(path)
+for name, data in images.items():
+    with open(os.path.join(work, name + '.bin'), 'wb') as f:
+        f.write(data)
+EOF
+
+printf '%-20s %7s   compressed size and ratio with window/lookahead\n' image bytes
+printf '%-20s %7s   %-14s %-14s %-14s %-14s %-14s\n' '' '' w4l3 w8l4 w10l5 w12l4 w12l11
+for img in "$WORK"/*.bin; do
+    size=$(wc -c <"$img")
+    line=$(printf '%-20s %7d ' "$(basename "$img" .bin)" "$size")
+    for wl in 4:3 8:4 10:5 12:4 12:11; do
+        hs="$img.w${wl%:*}l${wl#*:}.hs"
+        "$PYTHON" "$REPO/main/ota_compress.py" -w "${wl%:*}" -l "${wl#*:}" -o "$hs" "$img" \
+            >/dev/null 2>&1 || { echo "$img: ota_compress.py failed"; exit 1; }
+        "$DECODER" "$hs" "$img" >/dev/null
+        line="$line $(awk -v hs="$(wc -c <"$hs")" -v bin="$size" \
+            'BEGIN { printf "%7d %5.1f%%", hs, bin ? 100 * hs / bin : 0 }')"
+    done
+    echo "$line"
+done
@@ -0,0 +1,236 @@
+/*
+ * Copyright (c) 2025 <qb4.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+/*
+ * Downloads image with main/ota_pull_dl.c over a minimal HTTP/1.1 client and
+ * compares it with original:
+ *   ota_pull_resume <url> <image.bin> <resume status|fail>
+ * Expected resume status is 206 when server honours Range, 200 when bytes
+ * already read are skipped, fail when download must give up.
+ */
+
+#include <netdb.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <ota_pull_dl.h>
+
+#define SIM_RETRIES 8
+
+struct esp_http_client {
+    char    host[64];
+    char    port[8];
+    char    path[128];
+    char    range[32];
+    int     timeout_ms;
+    int     sock;
+    int     status;
+    int64_t content_length;
+    int64_t body_read;
+};
+
+int host_verbose;
+
+static int opens;
+static int resume_status; // status of last reopen
+
+void vTaskDelay(TickType_t ticks)
+{
+}
+
+esp_http_client_handle_t esp_http_client_init(const esp_http_client_config_t *config)
+{
+    struct esp_http_client *client = calloc(1, sizeof(*client));
+
+    if (!client)
+        return NULL;
+    if (sscanf(config->url, "http://%63[^:/]:%7[0-9]%127s", client->host, client->port,
+               client->path) != 3) {
+        free(client);
+        return NULL;
+    }
+    client->timeout_ms = config->timeout_ms;
+    client->sock = -1;
+    return client;
+}
+
+esp_err_t esp_http_client_set_header(esp_http_client_handle_t client, const char *key,
+                                     const char *value)
+{
+    if (strcmp(key, "Range"))
+        return ESP_ERR_NOT_SUPPORTED;
+
+    snprintf(client->range, sizeof(client->range), "%s", value);
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_open(esp_http_client_handle_t client, int write_len)
+{
+    struct addrinfo  hints = { .ai_family = AF_INET, .ai_socktype = SOCK_STREAM };
+    struct addrinfo *ai;
+    struct timeval   tv = { .tv_sec = client->timeout_ms / 1000 };
+    char             req[320];
+    int              len;
+
+    if (getaddrinfo(client->host, client->port, &hints, &ai))
+        return ESP_FAIL;
+    client->sock = socket(ai->ai_family, ai->ai_socktype, 0);
+    if (client->sock >= 0 && connect(client->sock, ai->ai_addr, ai->ai_addrlen) < 0) {
+        close(client->sock);
+        client->sock = -1;
+    }
+    freeaddrinfo(ai);
+    if (client->sock < 0)
+        return ESP_FAIL;
+    setsockopt(client->sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    len = snprintf(req, sizeof(req), "GET %s HTTP/1.1\r\nHost: %s\r\n", client->path,
+                   client->host);
+    if (client->range[0])
+        len += snprintf(req + len, sizeof(req) - len, "Range: %s\r\n", client->range);
+    len += snprintf(req + len, sizeof(req) - len, "Connection: close\r\n\r\n");
+    if (send(client->sock, req, len, 0) != len)
+        return ESP_FAIL;
+    opens++;
+    return ESP_OK;
+}
+
+int64_t esp_http_client_fetch_headers(esp_http_client_handle_t client)
+{
+    char   hdr[1024];
+    size_t len = 0;
+    char  *line;
+
+    // byte by byte, body is left in socket
+    while (len < sizeof(hdr) - 1) {
+        if (recv(client->sock, hdr + len, 1, 0) != 1)
+            return -1;
+        hdr[++len] = 0;
+        if (len >= 4 && !memcmp(hdr + len - 4, "\r\n\r\n", 4))
+            break;
+    }
+    if (sscanf(hdr, "HTTP/1.%*d %d", &client->status) != 1)
+        return -1;
+
+    client->content_length = -1;
+    client->body_read = 0;
+    for (line = strtok(hdr, "\r\n"); line; line = strtok(NULL, "\r\n")) {
+        if (!strncasecmp(line, "Content-Length:", 15))
+            client->content_length = strtoll(line + 15, NULL, 10);
+    }
+    if (opens > 1)
+        resume_status = client->status;
+    return client->content_length;
+}
+
+int esp_http_client_get_status_code(esp_http_client_handle_t client)
+{
+    return client->status;
+}
+
+int esp_http_client_read(esp_http_client_handle_t client, char *buf, int len)
+{
+    int n;
+
+    if (client->content_length >= 0 && client->body_read + len > client->content_length)
+        len = client->content_length - client->body_read;
+    if (len <= 0)
+        return 0;
+
+    n = recv(client->sock, buf, len, 0);
+    if (n > 0)
+        client->body_read += n;
+    return n < 0 ? -1 : n;
+}
+
+esp_err_t esp_http_client_close(esp_http_client_handle_t client)
+{
+    if (client->sock >= 0)
+        close(client->sock);
+    client->sock = -1;
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_cleanup(esp_http_client_handle_t client)
+{
+    esp_http_client_close(client);
+    free(client);
+    return ESP_OK;
+}
+
+static uint8_t *load(const char *path, size_t *size)
+{
+    FILE    *f = fopen(path, "rb");
+    uint8_t *data = NULL;
+    long     len;
+
+    if (!f)
+        return NULL;
+    if (!fseek(f, 0, SEEK_END) && (len = ftell(f)) > 0 && !fseek(f, 0, SEEK_SET)) {
+        data = malloc(len);
+        if (data && fread(data, 1, len, f) != len) {
+            free(data);
+            data = NULL;
+        }
+        *size = len;
+    }
+    fclose(f);
+    return data;
+}
+
+int main(int argc, char *argv[])
+{
+    esp_http_client_config_t config = { .timeout_ms = 5000 };
+    ota_pull_dl_t            dl = { .retries = SIM_RETRIES };
+    uint8_t                 *orig, *out;
+    size_t                   size = 0, done = 0;
+    bool                     expect_fail, ok;
+    int                      n = 0;
+
+    if (argc != 4) {
+        fprintf(stderr, "usage: %s <url> <image.bin> <206|200|fail>\n", argv[0]);
+        return 2;
+    }
+    expect_fail = !strcmp(argv[3], "fail");
+    orig = load(argv[2], &size);
+    out = malloc(size);
+    config.url = argv[1];
+    dl.client = esp_http_client_init(&config);
+    if (!orig || !out || !dl.client) {
+        printf("%s: setup failed\n", argv[1]);
+        return 1;
+    }
+
+    if (ota_pull_dl_open(&dl) == ESP_OK) {
+        // odd sized reads like ota_update() chunks
+        while (done < size) {
+            n = ota_pull_dl_read(&dl, (char *)out + done, size - done < 1500 ? size - done : 1500);
+            if (n < 0)
+                break;
+            done += n;
+        }
+    }
+    esp_http_client_cleanup(dl.client);
+
+    if (expect_fail)
+        ok = n < 0 && dl.retries < 0;
+    else
+        ok = done == size && !memcmp(orig, out, size) && opens > 1 &&
+             resume_status == atoi(argv[3]);
+    printf("%s: %u/%u bytes, %d opens, resume status %d: %s\n", argv[1], (unsigned)done,
+           (unsigned)size, opens, resume_status, ok ? "ok" : "FAIL");
+    free(orig);
+    free(out);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,69 @@
+#!/bin/sh
+# Download image with main/ota_pull_dl.c from local HTTP server which drops
+# connections: ota_pull_resume.sh <ota_pull_resume binary> <work dir>
+set -e
+
+CLIENT=$1
+WORK=$2
+PYTHON=${PYTHON:-python3}
+
+mkdir -p "$WORK"
+rm -f "$WORK/port"
+"$PYTHON" -c 'import os, sys; open(sys.argv[1], "wb").write(b"\xe9" + os.urandom(60000))' \
+    "$WORK/image.bin"
+
+# /<mode>/image.bin, mode:
+#   range   - Range honoured with 206, connection dropped every 13000 bytes
+#   norange - Range ignored, whole image sent again, dropped like above
+#   broken  - first response dropped, resume answered with 500
+"$PYTHON" - "$WORK" <<'PY' &
+import http.server, os, sys
+work = sys.argv[1]
+CUT = 13000
+with open(os.path.join(work, 'image.bin'), 'rb') as f:
+    image = f.read()
+opens = {}
+
+class Handler(http.server.BaseHTTPRequestHandler):
+    def log_message(self, *args):
+        pass
+
+    def do_GET(self):
+        mode = self.path.split('/')[1]
+        n = opens[mode] = opens.get(mode, 0) + 1
+        start = 0
+        rng = self.headers.get('Range')
+        if mode == 'broken' and n > 1:
+            self.send_error(500)
+            return
+        if mode == 'range' and rng:
+            start = int(rng.split('=')[1].rstrip('-'))
+            self.send_response(206)
+            self.send_header('Content-Range', 'bytes %d-%d/%d' % (start, len(image) - 1, len(image)))
+        else:
+            self.send_response(200)
+        self.send_header('Content-Length', str(len(image) - start))
+        self.end_headers()
+        # each connection gets further, dropped before whole body is sent
+        self.wfile.write(image[start:min(len(image), n * CUT)])
+        self.close_connection = True
+
+srv = http.server.HTTPServer(('127.0.0.1', 0), Handler)
+with open(os.path.join(work, 'port.tmp'), 'w') as f:
+    f.write(str(srv.server_address[1]))
+os.rename(os.path.join(work, 'port.tmp'), os.path.join(work, 'port'))
+srv.serve_forever()
+PY
+SERVER=$!
+trap 'kill $SERVER 2>/dev/null' EXIT
+
+for i in $(seq 50); do
+    [ -f "$WORK/port" ] && break
+    sleep 0.1
+done
+PORT=$(cat "$WORK/port")
+URL=http://127.0.0.1:$PORT
+
+"$CLIENT" "$URL/range/image.bin" "$WORK/image.bin" 206
+"$CLIENT" "$URL/norange/image.bin" "$WORK/image.bin" 200
+"$CLIENT" "$URL/broken/image.bin" "$WORK/image.bin" fail
@@ -0,0 +1,317 @@
+/*
+ * Copyright (c) 2025 <qb4.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+/*
+ * Roller shutter channel against simulated motor on virtual clock. Scenarios
+ * are run for each motor setup and position errors are reported:
+ *  - motor: where simulated motor really stopped vs requested target,
+ *  - report: position reported to server vs where motor really is.
+ * Exit status is nonzero when an error of checked setup exceeds the limit.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <rs-channel.h>
+#include "mock.h"
+
+#define SIM_GPIO_OPEN 4
+#define SIM_GPIO_CLOSE 5
+#define SIM_MAX_ERROR 1.0 //% of travel
+#define SIM_SETTLE_US (40 * 1000000LL)
+
+struct sim_motor {
+    int64_t open_us;        // full travel times
+    int64_t close_us;
+    int64_t tilt_us;        // 0 when there are no slats
+    int64_t start_delay_us; // motor starts this long after output is on
+    int64_t run_on_us;      // motor stops this long after output is off
+    double  pos;            // 0 - opened; 100 - closed
+    double  tilt;
+    int     out;      // direction set by outputs
+    int     dir;      // direction motor really turns
+    int64_t start_us; // motor starts turning in out direction
+    int64_t stop_us;  // motor stops turning when outputs are off
+};
+
+struct sim_setup {
+    const char *name;
+    int         func;
+    int         tilt_ms;
+    int         start_delay_ms; // of simulated motor
+    int         run_on_ms;
+    bool        compensate; // motor timing is set on channel
+    int         latency_ms; // timer callbacks are late up to this
+    bool        journal;
+    bool        checked; // errors count for exit status
+};
+
+struct sim_result {
+    double motor_err;
+    double report_err;
+};
+
+static struct sim_motor motor;
+
+static double sim_clamp(double val)
+{
+    return val < 0 ? 0 : val > 100 ? 100 : val;
+}
+
+static void sim_motor_step(int64_t now_us, int64_t step_us)
+{
+    const int out = host_gpio_get(SIM_GPIO_CLOSE) - host_gpio_get(SIM_GPIO_OPEN);
+    double    run_us = step_us;
+    double    tilt_end, tilt_run_us;
+
+    if (out != motor.out) {
+        if (out) {
+            // reversed without a stop motor is stopped at once
+            if (motor.dir != out)
+                motor.dir = 0;
+            motor.start_us = motor.dir ? now_us : now_us + motor.start_delay_us;
+        } else {
+            motor.stop_us = now_us + motor.run_on_us;
+        }
+        motor.out = out;
+    }
+    if (motor.out && !motor.dir && now_us >= motor.start_us)
+        motor.dir = motor.out;
+    if (!motor.out && motor.dir && now_us >= motor.stop_us)
+        motor.dir = 0;
+    if (!motor.dir)
+        return;
+
+    if (motor.tilt_us) {
+        tilt_end = motor.dir > 0 ? 100 : 0;
+        tilt_run_us = fabs(tilt_end - motor.tilt) * motor.tilt_us / 100;
+        if (run_us < tilt_run_us) {
+            motor.tilt += motor.dir * 100.0 * run_us / motor.tilt_us;
+            return;
+        }
+        motor.tilt = tilt_end;
+        run_us -= tilt_run_us;
+    }
+    motor.pos += motor.dir * 100.0 * run_us / (motor.dir > 0 ? motor.close_us : motor.open_us);
+    motor.pos = sim_clamp(motor.pos);
+}
+
+/*
+ * Motor is checked against target, reported value against motor. Target
+ * below 0 is not checked.
+ */
+static void sim_check(supla_channel_t *ch, struct sim_result *res, const char *step, int pos,
+                      int tilt)
+{
+    int    rep_pos, rep_tilt;
+    double motor_err = 0, report_err;
+
+    host_channel_value(ch, &rep_pos, &rep_tilt);
+    if (pos >= 0)
+        motor_err = fabs(motor.pos - pos);
+    if (tilt >= 0 && motor.tilt_us)
+        motor_err = fmax(motor_err, fabs(motor.tilt - tilt));
+    report_err = fabs(rep_pos - motor.pos);
+    if (motor.tilt_us)
+        report_err = fmax(report_err, fabs(rep_tilt - motor.tilt));
+
+    res->motor_err = fmax(res->motor_err, motor_err);
+    res->report_err = fmax(res->report_err, report_err);
+    if (host_verbose) {
+        printf("    %-24s motor %6.2f/%6.2f  report %3d/%3d\n", step, motor.pos, motor.tilt,
+               rep_pos, rep_tilt);
+    }
+}
+
+static void sim_target(supla_channel_t *ch, struct sim_result *res, const char *step, int pos,
+                       int tilt)
+{
+    supla_rs_channel_set_target(ch, pos, tilt);
+    host_run(SIM_SETTLE_US);
+    sim_check(ch, res, step, pos, tilt);
+}
+
+// position unknown to channel, calibration run is made first
+static void sim_calibrate(supla_channel_t *ch, struct sim_result *res)
+{
+    sim_target(ch, res, "calibrate, 37/20", 37, 20);
+}
+
+static void sim_steps(supla_channel_t *ch, struct sim_result *res)
+{
+    char step[32];
+
+    for (int pos = 47; pos <= 87; pos += 10) {
+        snprintf(step, sizeof(step), "+10%%, %d", pos);
+        sim_target(ch, res, step, pos, -1);
+    }
+    for (int pos = 77; pos >= 7; pos -= 10) {
+        snprintf(step, sizeof(step), "-10%%, %d", pos);
+        sim_target(ch, res, step, pos, -1);
+    }
+}
+
+static void sim_small_steps(supla_channel_t *ch, struct sim_result *res)
+{
+    sim_target(ch, res, "50", 50, -1);
+    for (int i = 0; i < 4; i++) {
+        sim_target(ch, res, "+2%, 52", 52, -1);
+        sim_target(ch, res, "-2%, 50", 50, -1);
+    }
+}
+
+static void sim_reverse(supla_channel_t *ch, struct sim_result *res)
+{
+    supla_rs_channel_set_target(ch, 10, -1);
+    host_run(3 * 1000000LL); // reported every 500 ms while moving, not checked here
+    sim_target(ch, res, "reversed, 80", 80, -1);
+}
+
+static void sim_step_by_step(supla_channel_t *ch, struct sim_result *res)
+{
+    supla_rs_channel_step_by_step(ch);
+    host_run(3 * 1000000LL);
+    supla_rs_channel_step_by_step(ch);
+    host_run(2 * 1000000LL);
+    sim_check(ch, res, "sbs, stopped", -1, -1);
+    supla_rs_channel_step_by_step(ch);
+    host_run(SIM_SETTLE_US);
+    sim_check(ch, res, "sbs, end", motor.pos < 50 ? 0 : 100, -1);
+}
+
+static void sim_tilt(supla_channel_t *ch, struct sim_result *res)
+{
+    sim_target(ch, res, "tilt 80", -1, 80);
+    sim_target(ch, res, "60/50", 60, 50);
+    sim_target(ch, res, "tilt 0", -1, 0);
+}
+
+static const struct {
+    const char *name;
+    void (*run)(supla_channel_t *ch, struct sim_result *res);
+    bool tilt; // facade blind only
+} scenarios[] = {
+    { "calibrate", sim_calibrate },
+    { "10% steps", sim_steps },
+    { "2% steps", sim_small_steps },
+    { "reverse", sim_reverse },
+    { "step-by-step", sim_step_by_step },
+    { "tilt", sim_tilt, true },
+};
+
+static const struct sim_setup setups[] = {
+    { "roller shutter, ideal motor", SUPLA_CHANNELFNC_CONTROLLINGTHEROLLERSHUTTER, 0, 0, 0,
+      false, 0, true, true },
+    { "roller shutter, motor timing", SUPLA_CHANNELFNC_CONTROLLINGTHEROLLERSHUTTER, 0, 250, 150,
+      true, 0, true, true },
+    { "roller shutter, no compensation", SUPLA_CHANNELFNC_CONTROLLINGTHEROLLERSHUTTER, 0, 250,
+      150, false, 0, true, false },
+    { "roller shutter, tick timer, nvs", SUPLA_CHANNELFNC_CONTROLLINGTHEROLLERSHUTTER, 0, 250,
+      150, true, 10, false, true },
+    { "facade blind, motor timing", SUPLA_CHANNELFNC_CONTROLLINGTHEFACADEBLIND, 1500, 250, 150,
+      true, 0, true, true },
+};
+
+static bool sim_run_setup(const struct sim_setup *setup)
+{
+    const struct rs_channel_config config = {
+        .gpio_open = SIM_GPIO_OPEN,
+        .gpio_close = SIM_GPIO_CLOSE,
+        .supported_functions = RS_CH_SUPPORTED_FUNC_BITS,
+        .default_function = setup->func,
+    };
+    const TChannelConfig_FacadeBlind srv_config = {
+        .OpeningTimeMS = 20000,
+        .ClosingTimeMS = 19000,
+        .TiltingTimeMS = setup->tilt_ms,
+    };
+    supla_channel_t *ch;
+    bool             ok = true;
+
+    motor = (struct sim_motor){
+        .open_us = srv_config.OpeningTimeMS * 1000LL,
+        .close_us = srv_config.ClosingTimeMS * 1000LL,
+        .tilt_us = setup->tilt_ms * 1000LL,
+        .start_delay_us = setup->start_delay_ms * 1000LL,
+        .run_on_us = setup->run_on_ms * 1000LL,
+        .pos = 63,
+        .tilt = 40,
+    };
+    host_timer_latency_us = setup->latency_ms * 1000LL;
+    host_journal_enable(setup->journal);
+
+    ch = supla_rs_channel_create(&config);
+    if (!ch) {
+        printf("%s: channel not created\n", setup->name);
+        return false;
+    }
+    host_channel_init(ch);
+    host_channel_config(ch, &srv_config,
+                        setup->tilt_ms ? sizeof(TChannelConfig_FacadeBlind) :
+                                         sizeof(TChannelConfig_RollerShutter));
+    if (setup->compensate)
+        supla_rs_channel_set_motor_timing(ch, setup->start_delay_ms, setup->run_on_ms);
+
+    printf("%s%s\n", setup->name, setup->checked ? "" : " (not checked)");
+    for (int i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+        struct sim_result res = { 0 };
+        bool              fail;
+
+        if (scenarios[i].tilt && !setup->tilt_ms)
+            continue;
+        scenarios[i].run(ch, &res);
+        fail = setup->checked && (res.motor_err > SIM_MAX_ERROR || res.report_err > SIM_MAX_ERROR);
+        printf("  %-16s motor error %5.2f%%  report error %5.2f%%%s\n", scenarios[i].name,
+               res.motor_err, res.report_err, fail ? "  FAIL" : "");
+        ok = ok && !fail;
+    }
+    host_run(SIM_SETTLE_US); // pending NVS store
+    printf("  nvs writes %u, journal writes %u, journal erases %u\n", host_stats.nvs_writes,
+           host_stats.journal_writes, host_stats.journal_erases);
+    supla_rs_channel_delete(ch);
+    return ok;
+}
+
+int main(int argc, char *argv[])
+{
+    bool ok = true;
+    int  opt;
+
+    while ((opt = getopt(argc, argv, "v")) != -1) {
+        if (opt == 'v') {
+            host_verbose = 1;
+        } else {
+            fprintf(stderr, "usage: %s [-v]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    host_set_step_cb(sim_motor_step);
+    // journal and libsupla state is per process, each setup starts from fresh boot
+    for (int i = 0; i < sizeof(setups) / sizeof(setups[0]); i++) {
+        pid_t pid;
+        int   status;
+
+        fflush(stdout);
+        pid = fork();
+        if (pid == 0) {
+            ok = sim_run_setup(&setups[i]);
+            if (host_stats.mutex_errors) {
+                printf("  mutex taken twice %u times\n", host_stats.mutex_errors);
+                ok = false;
+            }
+            fflush(stdout);
+            _exit(ok ? 0 : 1);
+        }
+        if (pid < 0 || waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) ||
+            WEXITSTATUS(status))
+            ok = false;
+    }
+    printf("%s\n", ok ? "PASSED" : "FAILED");
+    return ok ? 0 : 1;
+}
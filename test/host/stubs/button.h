@@ -0,0 +1,27 @@
+/*
+ * Host build stand-in for button component, only what tested boards use.
+ */
+
+#ifndef HOST_BUTTON_H_
+#define HOST_BUTTON_H_
+
+#include "esp_err.h"
+#include "driver/gpio.h"
+
+typedef enum {
+    BUTTON_PRESSED,
+    BUTTON_RELEASED,
+    BUTTON_CLICKED,
+    BUTTON_PRESSED_LONG,
+} button_state_t;
+
+typedef struct button button_t;
+
+struct button {
+    gpio_num_t gpio;
+    void (*callback)(button_t *btn, button_state_t state);
+};
+
+esp_err_t button_init(button_t *btn);
+
+#endif /* HOST_BUTTON_H_ */
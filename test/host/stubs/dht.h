@@ -0,0 +1,16 @@
+/*
+ * Host build stand-in for esp-idf-lib dht driver, readings are simulated.
+ */
+
+#ifndef HOST_DHT_H_
+#define HOST_DHT_H_
+
+#include "esp_err.h"
+#include "driver/gpio.h"
+
+typedef enum { DHT_TYPE_DHT11, DHT_TYPE_AM2301, DHT_TYPE_SI7021 } dht_sensor_type_t;
+
+esp_err_t dht_read_float_data(dht_sensor_type_t type, gpio_num_t pin, float *humidity,
+                              float *temperature);
+
+#endif /* HOST_DHT_H_ */
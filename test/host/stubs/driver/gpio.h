@@ -0,0 +1,31 @@
+/*
+ * Host build stand-in for ESP-IDF header, only what tested sources use.
+ */
+
+#ifndef HOST_DRIVER_GPIO_H_
+#define HOST_DRIVER_GPIO_H_
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#define GPIO_NUM_MAX 40
+
+typedef int gpio_num_t;
+
+#define GPIO_NUM_NC -1
+#define GPIO_NUM_0 0
+#define GPIO_NUM_2 2
+
+typedef enum { GPIO_MODE_OUTPUT } gpio_mode_t;
+typedef enum { GPIO_INTR_DISABLE } gpio_int_type_t;
+
+typedef struct {
+    uint64_t        pin_bit_mask;
+    gpio_mode_t     mode;
+    gpio_int_type_t intr_type;
+} gpio_config_t;
+
+esp_err_t gpio_config(const gpio_config_t *config);
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level);
+
+#endif /* HOST_DRIVER_GPIO_H_ */
@@ -0,0 +1,147 @@
+/*
+ * Host build stand-in for esp-libsupla: types, constants and channel API
+ * used by tested channels. Values of constants do not match SUPLA protocol.
+ */
+
+#ifndef HOST_ESP_SUPLA_H_
+#define HOST_ESP_SUPLA_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+typedef struct supla_channel supla_channel_t;
+typedef struct supla_dev     supla_dev_t;
+
+typedef enum {
+    SUPLA_DEV_STATE_IDLE,
+    SUPLA_DEV_STATE_INIT,
+    SUPLA_DEV_STATE_CONNECTED,
+    SUPLA_DEV_STATE_REGISTERED,
+    SUPLA_DEV_STATE_ONLINE,
+    SUPLA_DEV_STATE_CONFIG,
+} supla_dev_state_t;
+
+typedef struct {
+    char     value[8];
+    uint32_t DurationMS;
+} TSD_SuplaChannelNewValue;
+
+typedef struct {
+    int32_t OpeningTimeMS;
+    int32_t ClosingTimeMS;
+} TChannelConfig_RollerShutter;
+
+typedef struct {
+    int32_t OpeningTimeMS;
+    int32_t ClosingTimeMS;
+    int32_t TiltingTimeMS;
+} TChannelConfig_FacadeBlind;
+
+typedef struct {
+    int8_t   position;
+    uint8_t  reserved;
+    uint8_t  bottom_position;
+    uint16_t flags;
+} TDSC_RollerShutterValue;
+
+typedef struct {
+    int8_t   position;
+    int8_t   tilt;
+    uint8_t  reserved[2];
+    uint16_t flags;
+} TDSC_FacadeBlindValue;
+
+typedef struct {
+    uint8_t hi;
+    uint8_t flags;
+} TRelayChannel_Value;
+
+typedef struct {
+    uint8_t  ChannelNumber;
+    int32_t  Func;
+    uint8_t  ConfigType;
+    uint16_t ConfigSize;
+    char     Config[128];
+} TSD_ChannelConfig;
+
+typedef TSD_ChannelConfig TSDS_SetChannelConfig;
+
+typedef struct {
+    int32_t ChannelNumber;
+    int32_t Command;
+    int32_t DataType;
+    int32_t DataSize;
+} TSD_DeviceCalCfgRequest;
+
+typedef struct {
+    int          type;
+    const char  *default_caption;
+    unsigned int supported_functions;
+    int          default_function;
+    int          flags;
+    bool         sync_values_onchange;
+    int (*on_channel_init)(supla_channel_t *ch);
+    int (*on_set_value)(supla_channel_t *ch, TSD_SuplaChannelNewValue *new_value);
+    int (*on_calcfg_req)(supla_channel_t *ch, TSD_DeviceCalCfgRequest *calcfg);
+    int (*on_config_set)(supla_channel_t *ch, TSDS_SetChannelConfig *config);
+    int (*on_config_recv)(supla_channel_t *ch, TSD_ChannelConfig *config);
+} supla_channel_config_t;
+
+enum {
+    SUPLA_CHANNELTYPE_RELAY = 2900,
+    SUPLA_CHANNELTYPE_HUMIDITYANDTEMPSENSOR = 3038,
+    SUPLA_CHANNELFNC_HUMIDITYANDTEMPERATURE = 45,
+    SUPLA_CHANNELFNC_CONTROLLINGTHEGARAGEDOOR = 20,
+    SUPLA_CHANNELFNC_CONTROLLINGTHEROLLERSHUTTER = 110,
+    SUPLA_CHANNELFNC_CONTROLLINGTHEROOFWINDOW = 115,
+    SUPLA_CHANNELFNC_TERRACE_AWNING = 910,
+    SUPLA_CHANNELFNC_PROJECTOR_SCREEN = 920,
+    SUPLA_CHANNELFNC_CURTAIN = 930,
+    SUPLA_CHANNELFNC_VERTICAL_BLIND = 940,
+    SUPLA_CHANNELFNC_CONTROLLINGTHEFACADEBLIND = 900,
+};
+
+#define SUPLA_BIT_FUNC_CONTROLLINGTHEROLLERSHUTTER (1 << 6)
+#define SUPLA_BIT_FUNC_CONTROLLINGTHEROOFWINDOW (1 << 7)
+#define SUPLA_BIT_FUNC_CONTROLLINGTHEFACADEBLIND (1 << 24)
+#define SUPLA_BIT_FUNC_TERRACE_AWNING (1 << 25)
+#define SUPLA_BIT_FUNC_PROJECTOR_SCREEN (1 << 26)
+#define SUPLA_BIT_FUNC_CURTAIN (1 << 27)
+#define SUPLA_BIT_FUNC_VERTICAL_BLIND (1 << 28)
+#define SUPLA_BIT_FUNC_ROLLER_GARAGE_DOOR (1 << 29)
+
+#define SUPLA_CHANNEL_FLAG_CHANNELSTATE 0x00010000
+#define SUPLA_CHANNEL_FLAG_RS_SBS_AND_STOP_ACTIONS 0x00080000
+#define SUPLA_CONFIG_TYPE_DEFAULT 0
+#define SUPLA_CALCFG_CMD_RECALIBRATE 8000
+#define SUPLA_CALCFG_RESULT_FALSE 0
+#define SUPLA_CALCFG_RESULT_IN_PROGRESS 3
+#define SUPLA_RESULTCODE_TRUE 3
+#define SUPLA_RESULT_TRUE 1
+#define RS_VALUE_FLAG_TILT_IS_SET 0x1
+#define RS_VALUE_FLAG_CALIBRATION_IN_PROGRESS 0x4
+
+enum { LOG_ERR = 3, LOG_WARNING = 4, LOG_INFO = 6, LOG_DEBUG = 7 };
+
+void supla_log(int prio, const char *format, ...);
+
+supla_channel_t *supla_channel_create(const supla_channel_config_t *config);
+int              supla_channel_free(supla_channel_t *ch);
+void            *supla_channel_get_data(supla_channel_t *ch);
+int              supla_channel_set_data(supla_channel_t *ch, void *data);
+int              supla_channel_get_assigned_number(supla_channel_t *ch);
+int              supla_channel_get_active_function(supla_channel_t *ch, int *func);
+int              supla_channel_set_active_function(supla_channel_t *ch, int func);
+int supla_channel_set_roller_shutter_value(supla_channel_t *ch, TDSC_RollerShutterValue *value);
+int supla_channel_set_facadeblind_value(supla_channel_t *ch, TDSC_FacadeBlindValue *value);
+int supla_channel_set_humidtemp_value(supla_channel_t *ch, double humidity, double temp);
+
+int supla_dev_add_channel(supla_dev_t *dev, supla_channel_t *ch);
+int supla_dev_get_state(supla_dev_t *dev, supla_dev_state_t *state);
+
+esp_err_t supla_esp_nvs_channel_state_store(supla_channel_t *ch, const void *state, size_t len);
+esp_err_t supla_esp_nvs_channel_state_restore(supla_channel_t *ch, void *state, size_t len);
+
+#endif /* HOST_ESP_SUPLA_H_ */
@@ -0,0 +1,11 @@
+/*
+ * Host build stand-in for ESP-IDF header. RTC data is kept in its own section,
+ * so simulation may carry it over deep sleep resets.
+ */
+
+#ifndef HOST_ESP_ATTR_H_
+#define HOST_ESP_ATTR_H_
+
+#define RTC_DATA_ATTR __attribute__((section("host_rtc")))
+
+#endif /* HOST_ESP_ATTR_H_ */
@@ -0,0 +1,28 @@
+/*
+ * Host build stand-in for ESP-IDF header, only what tested sources use.
+ */
+
+#ifndef HOST_ESP_HTTP_CLIENT_H_
+#define HOST_ESP_HTTP_CLIENT_H_
+
+#include <stdint.h>
+#include "esp_err.h"
+
+typedef struct esp_http_client *esp_http_client_handle_t;
+
+typedef struct {
+    const char *url;
+    int         timeout_ms;
+} esp_http_client_config_t;
+
+esp_http_client_handle_t esp_http_client_init(const esp_http_client_config_t *config);
+esp_err_t esp_http_client_set_header(esp_http_client_handle_t client, const char *key,
+                                     const char *value);
+esp_err_t esp_http_client_open(esp_http_client_handle_t client, int write_len);
+int64_t   esp_http_client_fetch_headers(esp_http_client_handle_t client);
+int       esp_http_client_get_status_code(esp_http_client_handle_t client);
+int       esp_http_client_read(esp_http_client_handle_t client, char *buf, int len);
+esp_err_t esp_http_client_close(esp_http_client_handle_t client);
+esp_err_t esp_http_client_cleanup(esp_http_client_handle_t client);
+
+#endif /* HOST_ESP_HTTP_CLIENT_H_ */
@@ -0,0 +1,28 @@
+/*
+ * Host build stand-in for ESP-IDF header, only what tested sources use.
+ */
+
+#ifndef HOST_ESP_HTTP_SERVER_H_
+#define HOST_ESP_HTTP_SERVER_H_
+
+#include <sys/types.h>
+#include "esp_err.h"
+
+typedef void *httpd_handle_t;
+typedef struct httpd_req httpd_req_t;
+
+typedef enum { HTTP_GET = 1 } httpd_method_t;
+
+typedef struct {
+    const char    *uri;
+    httpd_method_t method;
+    esp_err_t (*handler)(httpd_req_t *req);
+    void          *user_ctx;
+} httpd_uri_t;
+
+esp_err_t httpd_resp_set_status(httpd_req_t *req, const char *status);
+esp_err_t httpd_resp_set_hdr(httpd_req_t *req, const char *field, const char *value);
+esp_err_t httpd_resp_send(httpd_req_t *req, const char *buf, ssize_t len);
+esp_err_t httpd_register_uri_handler(httpd_handle_t handle, const httpd_uri_t *uri);
+
+#endif /* HOST_ESP_HTTP_SERVER_H_ */
@@ -0,0 +1,23 @@
+/*
+ * Host build stand-in for ESP-IDF header, only what tested sources use.
+ */
+
+#ifndef HOST_ESP_LOG_H_
+#define HOST_ESP_LOG_H_
+
+#include <stdio.h>
+
+extern int host_verbose;
+
+#define HOST_LOG(tag, fmt, ...)                                  \
+    do {                                                         \
+        if (host_verbose)                                        \
+            printf("  %s: " fmt "\n", tag, ##__VA_ARGS__);       \
+    } while (0)
+
+#define ESP_LOGE(tag, fmt, ...) HOST_LOG(tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) HOST_LOG(tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...) HOST_LOG(tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGD(tag, fmt, ...) HOST_LOG(tag, fmt, ##__VA_ARGS__)
+
+#endif /* HOST_ESP_LOG_H_ */
@@ -0,0 +1,15 @@
+/*
+ * Host build stand-in for ESP-IDF header, sleep is simulated.
+ */
+
+#ifndef HOST_ESP_SLEEP_H_
+#define HOST_ESP_SLEEP_H_
+
+#include <stdint.h>
+#include "esp_err.h"
+
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t time_in_us);
+esp_err_t esp_light_sleep_start(void);
+void      esp_deep_sleep(uint64_t time_in_us) __attribute__((noreturn));
+
+#endif /* HOST_ESP_SLEEP_H_ */
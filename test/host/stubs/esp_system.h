@@ -0,0 +1,18 @@
+/*
+ * Host build stand-in for ESP-IDF header, only what tested sources use.
+ */
+
+#ifndef HOST_ESP_SYSTEM_H_
+#define HOST_ESP_SYSTEM_H_
+
+#include <stdint.h>
+#include "esp_err.h"
+
+typedef enum {
+    ESP_RST_POWERON,
+    ESP_RST_DEEPSLEEP,
+} esp_reset_reason_t;
+
+esp_reset_reason_t esp_reset_reason(void);
+
+#endif /* HOST_ESP_SYSTEM_H_ */
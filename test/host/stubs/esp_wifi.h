@@ -0,0 +1,11 @@
+/*
+ * Host build stand-in for ESP-IDF header, only what tested sources use.
+ */
+
+#ifndef HOST_ESP_WIFI_H_
+#define HOST_ESP_WIFI_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#endif /* HOST_ESP_WIFI_H_ */
@@ -0,0 +1,19 @@
+/*
+ * Host build stand-in for FreeRTOS header, simulation is single threaded.
+ */
+
+#ifndef HOST_FREERTOS_H_
+#define HOST_FREERTOS_H_
+
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef int      BaseType_t;
+
+#define portMAX_DELAY 0xffffffffUL
+#define pdMS_TO_TICKS(ms) (ms)
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS pdTRUE
+
+#endif /* HOST_FREERTOS_H_ */
@@ -0,0 +1,18 @@
+/*
+ * Host build stand-in for FreeRTOS header, only what tested sources use.
+ */
+
+#ifndef HOST_EVENT_GROUPS_H_
+#define HOST_EVENT_GROUPS_H_
+
+#include "FreeRTOS.h"
+
+typedef uint32_t                   EventBits_t;
+typedef struct host_event_group   *EventGroupHandle_t;
+
+#define BIT0 (1 << 0)
+#define BIT1 (1 << 1)
+#define BIT2 (1 << 2)
+#define BIT3 (1 << 3)
+
+#endif /* HOST_EVENT_GROUPS_H_ */
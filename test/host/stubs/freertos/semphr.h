@@ -0,0 +1,16 @@
+/*
+ * Host build stand-in for FreeRTOS header, simulation is single threaded.
+ */
+
+#ifndef HOST_FREERTOS_SEMPHR_H_
+#define HOST_FREERTOS_SEMPHR_H_
+
+#include "FreeRTOS.h"
+
+typedef struct host_mutex *SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+BaseType_t        xSemaphoreTake(SemaphoreHandle_t mutex, TickType_t ticks);
+BaseType_t        xSemaphoreGive(SemaphoreHandle_t mutex);
+
+#endif /* HOST_FREERTOS_SEMPHR_H_ */
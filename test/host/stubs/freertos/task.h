@@ -0,0 +1,20 @@
+/*
+ * Host build stand-in for FreeRTOS header, only what tested sources use.
+ */
+
+#ifndef HOST_TASK_H_
+#define HOST_TASK_H_
+
+#include "FreeRTOS.h"
+
+typedef struct host_task *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *arg);
+
+#define tskIDLE_PRIORITY 0
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack, void *arg,
+                       int prio, TaskHandle_t *handle);
+void       vTaskDelete(TaskHandle_t task);
+void       vTaskDelay(TickType_t ticks);
+
+#endif /* HOST_TASK_H_ */
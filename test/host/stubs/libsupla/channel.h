@@ -0,0 +1,5 @@
+/*
+ * Host build stand-in for esp-libsupla header.
+ */
+
+#include "../esp-supla.h"
@@ -0,0 +1,20 @@
+/*
+ * Host build stand-in for lwIP header, host sockets are used.
+ */
+
+#ifndef HOST_LWIP_SOCKETS_H_
+#define HOST_LWIP_SOCKETS_H_
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#define closesocket close
+
+// sockets are bound to loopback and a free port, not the privileged one asked
+int host_bind(int sock, const struct sockaddr *addr, socklen_t len);
+#define bind host_bind
+
+#endif /* HOST_LWIP_SOCKETS_H_ */
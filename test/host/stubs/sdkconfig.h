@@ -0,0 +1,3 @@
+/*
+ * Host build stand-in for generated sdkconfig.h, options are set by CMake.
+ */
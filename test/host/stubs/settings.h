@@ -0,0 +1,34 @@
+/*
+ * Host build stand-in for nvs-settings, only what tested boards use.
+ */
+
+#ifndef HOST_SETTINGS_H_
+#define HOST_SETTINGS_H_
+
+#include "esp_err.h"
+
+typedef enum { SETTING_TYPE_BOOL, SETTING_TYPE_NUM, SETTING_TYPE_ONEOF } setting_type_t;
+
+typedef struct {
+    const char    *id;
+    const char    *label;
+    setting_type_t type;
+    union {
+        struct {
+            int          def;
+            int          val;
+            const char **labels;
+        } oneof;
+    };
+} setting_t;
+
+typedef struct {
+    const char *id;
+    const char *label;
+    setting_t  *settings;
+} settings_group_t;
+
+esp_err_t  settings_nvs_read(const settings_group_t *pack);
+setting_t *settings_pack_find(const settings_group_t *pack, const char *group, const char *id);
+
+#endif /* HOST_SETTINGS_H_ */